@@ -0,0 +1,396 @@
+#pragma once
+
+// 参数化基准测试框架：logF、spdlog、glog 共用同一套场景、计时和输出。
+// 每个后端提供：
+//   explicit Backend(const Scenario&)    构造并启动日志库
+//   void log_numbers(int thread, int seq, double value)
+//   void log_string(int thread, const char* str)
+//   void finish()                         等待后端处理完所有消息
+//   uint64_t processed() const            后端实际处理的消息数（未知时返回发送数）
+// 可选：
+//   void stage_latency(StageLatency&)     finish() 之后填充端到端分段延迟（纳秒）
+//   pid_t consumer_thread_id() const      后台线程 id，--perf 时统计其计数器
+//   static uint64_t thread_cas_failures() 当前生产者线程累计的 CAS 失败次数
+
+#include "../include/latency_histogram.h"
+#include "perf_counters.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+static inline uint64_t rdtscp() {
+    uint64_t low, high;
+    // a = low, d = high, c = processor id
+    __asm__ __volatile__ (
+        "rdtscp"
+        : "=a"(low), "=d"(high)
+        :: "%rcx"
+    );
+    return (high << 32) | low;
+}
+
+// 用 steady_clock 校准 TSC 频率
+inline double tsc_ticks_per_ns() {
+    static const double ticks_per_ns = [] {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = rdtscp();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto t1 = std::chrono::steady_clock::now();
+        uint64_t c1 = rdtscp();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return static_cast<double>(c1 - c0) / ns;
+    }();
+    return ticks_per_ns;
+}
+
+enum class ArgKind { NUMBERS, STRING };
+enum class Pattern { BURST, STEADY };
+
+struct Scenario {
+    int threads = 8;
+    ArgKind args = ArgKind::NUMBERS;
+    size_t string_length = 16;
+    Pattern pattern = Pattern::BURST;
+    uint64_t rate_per_thread = 100000;   // STEADY：每线程每秒消息数
+    int burst_size = 10;                 // BURST：每批消息数，批间 sleep burst_gap
+    std::chrono::nanoseconds burst_gap{100};
+    size_t ring_size = 1024 * 64;
+    uint64_t messages_per_thread = 100000;
+    std::string log_dir = "logs/bench";
+    bool perf = false;                   // 是否用 perf_event_open 统计硬件计数器
+
+    std::string args_name() const {
+        return args == ArgKind::NUMBERS ? "numbers" : "str" + std::to_string(string_length);
+    }
+    std::string pattern_name() const {
+        return pattern == Pattern::BURST ? "burst" : "steady";
+    }
+};
+
+struct StageLatency {
+    bool available = false;
+    logF::LatencyHistogram queueing;
+    logF::LatencyHistogram formatting;
+    logF::LatencyHistogram io;
+};
+
+template<typename Backend, typename = void>
+struct has_consumer_thread_id : std::false_type {};
+
+template<typename Backend>
+struct has_consumer_thread_id<Backend, std::void_t<decltype(
+    std::declval<const Backend&>().consumer_thread_id())>> : std::true_type {};
+
+template<typename Backend, typename = void>
+struct has_cas_failures : std::false_type {};
+
+template<typename Backend>
+struct has_cas_failures<Backend, std::void_t<decltype(Backend::thread_cas_failures())>> : std::true_type {};
+
+template<typename Backend, typename = void>
+struct has_stage_latency : std::false_type {};
+
+template<typename Backend>
+struct has_stage_latency<Backend, std::void_t<decltype(
+    std::declval<Backend&>().stage_latency(std::declval<StageLatency&>()))>> : std::true_type {};
+
+struct Result {
+    Scenario scenario;
+    double elapsed_seconds = 0;
+    uint64_t sent = 0;
+    uint64_t processed = 0;
+    // 调用耗时（服务时间）
+    logF::LatencyHistogram service;
+    // STEADY 下从计划发送时刻开始计时，补偿协调遗漏；BURST 下批内没有计划发送时刻，从这一批开始发送时计时
+    logF::LatencyHistogram response;
+    StageLatency stages;
+    // --perf：生产者循环（所有线程之和）与消费者线程的计数器
+    PerfCounters::Values producer_counters;
+    PerfCounters::Values consumer_counters;
+    std::optional<uint64_t> cas_failures;
+};
+
+template<typename Backend>
+Result run_scenario(const Scenario& scenario) {
+    std::filesystem::remove_all(scenario.log_dir);
+    std::filesystem::create_directories(scenario.log_dir);
+
+    Result result;
+    result.scenario = scenario;
+    std::vector<logF::LatencyHistogram> service(scenario.threads);
+    std::vector<logF::LatencyHistogram> response(scenario.threads);
+    std::vector<PerfCounters::Values> producer_counters(scenario.threads);
+    std::vector<uint64_t> cas_failures(scenario.threads, 0);
+    const std::string payload(scenario.string_length, 'x');
+    const double ticks_per_ns = tsc_ticks_per_ns();
+    const uint64_t interval_ticks = scenario.pattern == Pattern::STEADY
+        ? static_cast<uint64_t>(1e9 / scenario.rate_per_thread * ticks_per_ns)
+        : 0;
+
+    {
+        Backend backend(scenario);
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < scenario.threads; ++t) {
+            threads.emplace_back([&, t]() {
+                auto& service_hist = service[t];
+                auto& response_hist = response[t];
+                std::optional<PerfCounters> counters;
+                if (scenario.perf) counters.emplace();
+                uint64_t cas_before = 0;
+                if constexpr (has_cas_failures<Backend>::value) cas_before = Backend::thread_cas_failures();
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) {}
+                if (counters) counters->start();
+                const uint64_t start = rdtscp();
+                uint64_t burst_start = start;
+                for (uint64_t j = 0; j < scenario.messages_per_thread; ++j) {
+                    uint64_t intended = 0;
+                    if (scenario.pattern == Pattern::STEADY) {
+                        intended = start + j * interval_ticks;
+                        while (rdtscp() < intended) {}
+                    }
+                    const uint64_t begin = rdtscp();
+                    if (scenario.args == ArgKind::NUMBERS) {
+                        backend.log_numbers(t, static_cast<int>(j), 3.14159 + j);
+                    } else {
+                        backend.log_string(t, payload.c_str());
+                    }
+                    const uint64_t end = rdtscp();
+                    service_hist.record(end - begin);
+                    if (scenario.pattern == Pattern::STEADY) {
+                        response_hist.record(end - intended);
+                    } else {
+                        response_hist.record(end - burst_start);
+                        if ((j + 1) % scenario.burst_size == 0) {
+                            std::this_thread::sleep_for(scenario.burst_gap);
+                            burst_start = rdtscp();
+                        }
+                    }
+                }
+                if (counters) {
+                    counters->stop();
+                    producer_counters[t] = counters->read();
+                }
+                if constexpr (has_cas_failures<Backend>::value) {
+                    cas_failures[t] = Backend::thread_cas_failures() - cas_before;
+                }
+            });
+        }
+        std::optional<PerfCounters> consumer_counters;
+        if constexpr (has_consumer_thread_id<Backend>::value) {
+            if (scenario.perf) consumer_counters.emplace(backend.consumer_thread_id());
+        }
+        while (ready.load() < scenario.threads) {}
+        if (consumer_counters) consumer_counters->start();
+        auto start_time = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        auto end_time = std::chrono::steady_clock::now();
+        backend.finish();
+        if (consumer_counters) {
+            consumer_counters->stop();
+            result.consumer_counters = consumer_counters->read();
+        }
+
+        result.elapsed_seconds = std::chrono::duration<double>(end_time - start_time).count();
+        result.sent = scenario.messages_per_thread * scenario.threads;
+        result.processed = backend.processed();
+        if constexpr (has_stage_latency<Backend>::value) {
+            backend.stage_latency(result.stages);
+        }
+    }
+
+    for (int t = 0; t < scenario.threads; ++t) {
+        result.service.merge(service[t]);
+        result.response.merge(response[t]);
+        if (scenario.perf) {
+            accumulate(result.producer_counters, producer_counters[t], t == 0);
+        }
+    }
+    if constexpr (has_cas_failures<Backend>::value) {
+        uint64_t total = 0;
+        for (uint64_t failures : cas_failures) total += failures;
+        result.cas_failures = total;
+    }
+    std::filesystem::remove_all(scenario.log_dir);
+    return result;
+}
+
+inline std::vector<std::string> split(const std::string& value) {
+    std::vector<std::string> parts;
+    std::stringstream ss(value);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+struct Options {
+    std::vector<int> threads{1, 2, 4, 8};
+    std::vector<std::string> args{"numbers", "str16", "str256"};
+    std::vector<std::string> patterns{"burst", "steady"};
+    std::vector<size_t> rings{1024 * 64};
+    uint64_t messages = 100000;
+    uint64_t rate = 100000;
+    bool perf = false;
+    std::string csv;
+};
+
+inline void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --threads 1,2,4,8      producer thread counts (1-64)\n"
+              << "  --args numbers,str16   argument kinds: numbers or str<length>\n"
+              << "  --pattern burst,steady message patterns\n"
+              << "  --ring 65536           ring sizes (power of 2)\n"
+              << "  --messages N           messages per thread\n"
+              << "  --rate N               steady-rate messages per second per thread\n"
+              << "  --full                 threads 1..64, strings 16/64/256, rings 4K/64K/1M\n"
+              << "  --perf                 count instructions, cache and branch misses per message\n"
+              << "  --csv FILE             write results as CSV\n";
+}
+
+inline bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--threads") {
+            options.threads.clear();
+            for (auto& v : split(next())) options.threads.push_back(std::clamp(std::stoi(v), 1, 64));
+        } else if (arg == "--args") {
+            options.args = split(next());
+        } else if (arg == "--pattern") {
+            options.patterns = split(next());
+        } else if (arg == "--ring") {
+            options.rings.clear();
+            for (auto& v : split(next())) options.rings.push_back(std::stoull(v));
+        } else if (arg == "--messages") {
+            options.messages = std::stoull(next());
+        } else if (arg == "--rate") {
+            options.rate = std::stoull(next());
+        } else if (arg == "--full") {
+            options.threads = {1, 2, 4, 8, 16, 32, 64};
+            options.args = {"numbers", "str16", "str64", "str256"};
+            options.rings = {1024 * 4, 1024 * 64, 1024 * 1024};
+        } else if (arg == "--perf") {
+            options.perf = true;
+        } else if (arg == "--csv") {
+            options.csv = next();
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+inline std::vector<Scenario> build_sweep(const Options& options) {
+    std::vector<Scenario> sweep;
+    for (size_t ring : options.rings)
+    for (const auto& pattern : options.patterns)
+    for (const auto& args : options.args)
+    for (int threads : options.threads) {
+        Scenario scenario;
+        scenario.threads = threads;
+        scenario.ring_size = ring;
+        scenario.pattern = pattern == "steady" ? Pattern::STEADY : Pattern::BURST;
+        if (args.rfind("str", 0) == 0) {
+            scenario.args = ArgKind::STRING;
+            scenario.string_length = std::stoull(args.substr(3));
+        }
+        scenario.messages_per_thread = options.messages;
+        scenario.rate_per_thread = options.rate;
+        scenario.perf = options.perf;
+        sweep.push_back(scenario);
+    }
+    return sweep;
+}
+
+inline const char* csv_header() {
+    return "backend,threads,args,pattern,rate_per_thread,ring_size,messages,processed,dropped,"
+           "throughput_msgs_per_sec,service_mean,service_p50,service_p99,service_p999,service_max,"
+           "response_p50,response_p99,response_p999,response_max,"
+           "queue_p50_ns,queue_p99_ns,format_p50_ns,format_p99_ns,io_p50_ns,io_p99_ns,"
+           "producer_instructions_per_msg,producer_cache_misses_per_msg,producer_branch_misses_per_msg,"
+           "producer_task_clock_ns_per_msg,consumer_instructions_per_msg,consumer_cache_misses_per_msg,"
+           "consumer_branch_misses_per_msg,consumer_task_clock_ns_per_msg,cas_failures_per_msg";
+}
+
+// 每条消息的计数器速率，缺失时输出空列
+inline void append_rate(std::ostringstream& os, const std::optional<uint64_t>& value, uint64_t messages) {
+    os << ',';
+    if (value && messages > 0) {
+        os << static_cast<double>(*value) / messages;
+    }
+}
+
+inline std::string csv_row(const std::string& backend, const Result& r) {
+    std::ostringstream os;
+    const auto& s = r.scenario;
+    os << backend << ',' << s.threads << ',' << s.args_name() << ',' << s.pattern_name() << ','
+       << (s.pattern == Pattern::STEADY ? s.rate_per_thread : 0) << ',' << s.ring_size << ','
+       << r.sent << ',' << r.processed << ',' << (r.sent > r.processed ? r.sent - r.processed : 0) << ','
+       << static_cast<uint64_t>(r.processed / r.elapsed_seconds) << ','
+       << static_cast<uint64_t>(r.service.mean()) << ',' << r.service.percentile(50) << ','
+       << r.service.percentile(99) << ',' << r.service.percentile(99.9) << ',' << r.service.max() << ','
+       << r.response.percentile(50) << ',' << r.response.percentile(99) << ','
+       << r.response.percentile(99.9) << ',' << r.response.max();
+    for (const auto* hist : {&r.stages.queueing, &r.stages.formatting, &r.stages.io}) {
+        if (r.stages.available) {
+            os << ',' << hist->percentile(50) << ',' << hist->percentile(99);
+        } else {
+            os << ",,";
+        }
+    }
+    for (const auto& value : r.producer_counters) append_rate(os, value, r.sent);
+    for (const auto& value : r.consumer_counters) append_rate(os, value, r.processed);
+    append_rate(os, r.cas_failures, r.sent);
+    return os.str();
+}
+
+// 运行整个扫描，打印结果并按需写出 CSV。所有延迟单位为 CPU 周期
+template<typename Backend>
+int run_main(int argc, char** argv, const std::string& backend_name) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+    std::ofstream csv;
+    if (!options.csv.empty()) {
+        csv.open(options.csv);
+        csv << csv_header() << "\n";
+    }
+    std::cout << csv_header() << std::endl;
+    for (const auto& scenario : build_sweep(options)) {
+        Result result = run_scenario<Backend>(scenario);
+        const std::string row = csv_row(backend_name, result);
+        std::cout << row << std::endl;
+        if (csv.is_open()) {
+            csv << row << "\n";
+            csv.flush();
+        }
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,62 @@
+// LOG_HEX 丢弃回归（ctest 使用）：消费者未启动、环形缓冲区已满时反复调用 LOG_HEX，
+// 复制的负载总量远超线程区域；之后启动消费者，新的 LOG_HEX 必须照常输出十六进制而不是 <blob dropped>。
+// 另外核对批次打开期间直接写入 logger 的负载先于批次内的负载输出（区域按槽位顺序回收）。
+//   blob_drop_check [LOG_DIR]
+
+#include "../include/logger.h"
+#include "../include/consumer.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+int main(int argc, char** argv) {
+    const std::string dir = argc > 1 ? argv[1] : "logs/blob_drop_check";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    logF::BlobArena::set_per_thread_capacity(8192);
+    logF::MpscRingBuffer<logF::LogMessage> ring_buffer(64);
+    logF::Logger logger(ring_buffer);
+    for (int i = 0; i < 100; ++i) {
+        LOG_INFO(logger, "filler %", i);
+    }
+
+    // 每条 1000 字节，1000 条远超 8 KB 区域；全部因缓冲区满被丢弃
+    uint8_t payload[1000] = {};
+    for (int i = 0; i < 1000; ++i) {
+        LOG_HEX(logger, "dropped %", payload, sizeof(payload));
+    }
+
+    {
+        logF::Consumer consumer(ring_buffer, dir);
+        consumer.start();
+        logger.flush().wait();  // 先等消费者清空缓冲区
+        const uint8_t marker[] = {0xde, 0xad, 0xbe, 0xef};
+        LOG_HEX(logger, "after drop %", marker, sizeof(marker));
+        {
+            auto batch = logger.batch(4);
+            const uint8_t direct[] = {0x01};
+            const uint8_t batched[] = {0x02};
+            LOG_HEX(logger, "direct %", direct, sizeof(direct));
+            LOG_HEX(batch, "batched %", batched, sizeof(batched));
+        }
+        logger.flush().wait();
+        consumer.stop();
+    }
+
+    std::string output;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        std::ifstream in(entry.path(), std::ios::binary);
+        output.append(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const bool printed = output.find("after drop deadbeef") != std::string::npos;
+    const bool dropped = output.find("<blob dropped>") != std::string::npos;
+    const size_t direct = output.find("direct 01");
+    const size_t batched = output.find("batched 02");
+    const bool ordered = direct != std::string::npos && batched != std::string::npos && direct < batched;
+    std::cout << "blob printed " << printed << ", blob dropped " << dropped << ", batch order kept " << ordered
+              << std::endl;
+    return printed && !dropped && ordered ? 0 : 1;
+}
@@ -0,0 +1,337 @@
+// 组件级微基准与性能回归门禁。
+//   micro_benchmark                       运行所有内核并打印 ns/op
+//   micro_benchmark --save FILE           运行并保存基线
+//   micro_benchmark --check FILE [--threshold 0.3]
+//                                         与基线比较，任一内核变慢超过阈值则返回 1；
+//                                         基线不存在时返回 77（CTest 视为跳过）
+// 输入使用固定种子生成，迭代次数固定，每个内核重复多次取最小值以降低噪声。
+
+#include "../include/ring_buffer.h"
+#include "../include/mmap_writer.h"
+#include "../include/mpsc_ring_buffer.h"
+#include "../include/log_message.h"
+#include "../include/time_cache.h"
+#include "../include/lz_block.h"
+#include "../include/logger.h"
+#include "../include/consumer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int REPETITIONS = 7;
+constexpr uint64_t SEED = 20240601;
+constexpr int SKIP_RETURN_CODE = 77;
+
+struct Kernel {
+    std::string name;
+    uint64_t ops;                        // 每次重复执行的操作数
+    std::function<void()> setup;         // 每次重复前调用，不计时
+    std::function<void()> body;
+};
+
+// 防止编译器把结果优化掉
+volatile uint64_t sink;
+
+double measure(const Kernel& kernel) {
+    double best = 1e300;
+    for (int rep = 0; rep < REPETITIONS; ++rep) {
+        if (kernel.setup) kernel.setup();
+        auto start = std::chrono::steady_clock::now();
+        kernel.body();
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / kernel.ops;
+        best = std::min(best, ns);
+    }
+    return best;
+}
+
+std::vector<Kernel> make_kernels() {
+    std::vector<Kernel> kernels;
+    std::mt19937_64 rng(SEED);
+
+    // CharRingBuffer::append_number(long long)
+    auto ints = std::make_shared<std::vector<long long>>(1 << 16);
+    for (auto& v : *ints) v = static_cast<long long>(rng() >> (rng() % 63)) * ((rng() & 1) ? 1 : -1);
+    auto char_buffer = std::make_shared<logF::CharRingBuffer>(1 << 22);
+    kernels.push_back({"char_buffer.append_number_int", ints->size(),
+        [char_buffer] { char_buffer->clear(); },
+        [ints, char_buffer] {
+            for (long long v : *ints) char_buffer->append_number(v);
+            sink = char_buffer->size();
+        }});
+
+    // CharRingBuffer::append_number(double)
+    auto doubles = std::make_shared<std::vector<double>>(1 << 16);
+    std::uniform_real_distribution<double> exponent(-12.0, 12.0);
+    for (auto& v : *doubles) v = std::pow(10.0, exponent(rng)) * ((rng() & 1) ? 1 : -1);
+    kernels.push_back({"char_buffer.append_number_double", doubles->size(),
+        [char_buffer] { char_buffer->clear(); },
+        [doubles, char_buffer] {
+            for (double v : *doubles) char_buffer->append_number(v);
+            sink = char_buffer->size();
+        }});
+
+    // CharRingBuffer::append_json_escaped：约 1/50 的字节需要转义，一次操作为一个 64 字节的字符串
+    constexpr size_t STRING_LEN = 64;
+    auto strings = std::make_shared<std::vector<char>>(STRING_LEN * 1024);
+    for (auto& c : *strings) c = (rng() % 50 == 0) ? "\"\\\n\t"[rng() % 4] : static_cast<char>('a' + rng() % 26);
+    kernels.push_back({"char_buffer.append_json_escaped", strings->size() / STRING_LEN,
+        [char_buffer] { char_buffer->clear(); },
+        [strings, char_buffer] {
+            for (size_t i = 0; i < strings->size(); i += STRING_LEN) {
+                char_buffer->append_json_escaped(strings->data() + i, STRING_LEN);
+            }
+            sink = char_buffer->size();
+        }});
+
+    // CharRingBuffer::append_hex：一次操作为一个 256 字节的报文（LOG_HEX）
+    constexpr size_t PACKET_LEN = 256;
+    auto packets = std::make_shared<std::vector<uint8_t>>(PACKET_LEN * 256);
+    for (auto& b : *packets) b = static_cast<uint8_t>(rng());
+    kernels.push_back({"char_buffer.append_hex", packets->size() / PACKET_LEN,
+        [char_buffer] { char_buffer->clear(); },
+        [packets, char_buffer] {
+            for (size_t i = 0; i < packets->size(); i += PACKET_LEN) {
+                char_buffer->append_hex(packets->data() + i, PACKET_LEN);
+            }
+            sink = char_buffer->size();
+        }});
+
+    // TimeCache::update_time_string：时间戳以随机的 0~2ms 步长递增，覆盖命中与未命中
+    auto timestamps = std::make_shared<std::vector<std::chrono::system_clock::time_point>>(1 << 16);
+    auto ts = std::chrono::system_clock::time_point(std::chrono::seconds(1700000000));
+    for (auto& t : *timestamps) {
+        ts += std::chrono::microseconds(rng() % 2000);
+        t = ts;
+    }
+    auto time_cache = std::make_shared<logF::TimeCache>();
+    kernels.push_back({"time_cache.update_time_string", timestamps->size(),
+        [time_cache] { *time_cache = logF::TimeCache(); },
+        [timestamps, time_cache] {
+            for (const auto& t : *timestamps) time_cache->update_time_string(t);
+            sink = static_cast<uint64_t>(time_cache->cached_milliseconds);
+        }});
+
+    // MpscRingBuffer::emplace 与 read：单线程填满后整批读出
+    constexpr size_t RING_SIZE = 1 << 14;
+    auto ring = std::make_shared<logF::MpscRingBuffer<logF::LogMessage>>(RING_SIZE);
+    kernels.push_back({"mpsc_ring.emplace", RING_SIZE * 8, nullptr,
+        [ring] {
+            for (int round = 0; round < 8; ++round) {
+                for (size_t i = 0; i < RING_SIZE; ++i) {
+                    ring->emplace(1u, logF::LogLevel::INFO, 0u, "bench %, %", static_cast<int>(i), 2.5);
+                }
+                auto view = ring->read();
+                sink = view.size();
+            }
+        }});
+    // reserve/commit：每 32 条一次申请，与 mpsc_ring.emplace 写入相同的消息
+    constexpr size_t BURST = 32;
+    kernels.push_back({"mpsc_ring.reserve", RING_SIZE * 8, nullptr,
+        [ring] {
+            for (int round = 0; round < 8; ++round) {
+                for (size_t i = 0; i < RING_SIZE; i += BURST) {
+                    auto reservation = ring->reserve(BURST);
+                    for (size_t j = 0; j < BURST; ++j) {
+                        reservation.emplace(1u, logF::LogLevel::INFO, 0u, "bench %, %", static_cast<int>(i + j), 2.5);
+                    }
+                    reservation.commit();
+                }
+                auto view = ring->read();
+                sink = view.size();
+            }
+        }});
+    kernels.push_back({"mpsc_ring.read", RING_SIZE,
+        [ring] {
+            for (size_t i = 0; i < RING_SIZE; ++i) {
+                ring->emplace(1u, logF::LogLevel::INFO, 0u, "bench %", static_cast<int>(i));
+            }
+        },
+        [ring] {
+            uint64_t total = 0;
+            auto view = ring->read();
+            for (const auto& msg : view) total += msg.args[0].as_int();
+            sink = total;
+        }});
+
+    // 弹性模式的 emplace：每批跨 4 段，包含段的接入与回收
+    logF::ElasticRingConfig elastic_config;
+    elastic_config.segment_slots = RING_SIZE / 4;
+    elastic_config.initial_slots = RING_SIZE / 4;
+    auto elastic_ring = std::make_shared<logF::MpscRingBuffer<logF::LogMessage>>(elastic_config);
+    kernels.push_back({"mpsc_ring.emplace_elastic", RING_SIZE * 8, nullptr,
+        [elastic_ring] {
+            for (int round = 0; round < 8; ++round) {
+                for (size_t i = 0; i < RING_SIZE; ++i) {
+                    elastic_ring->emplace(1u, logF::LogLevel::INFO, 0u, "bench %, %", static_cast<int>(i), 2.5);
+                }
+                auto view = elastic_ring->read();
+                sink = view.size();
+            }
+        }});
+
+    // MMapFileWriter::write：128 字节块写入新文件（包含首次访问页面的缺页开销）
+    const std::string dir = (std::filesystem::temp_directory_path() / "logF_micro_benchmark").string();
+    constexpr size_t CHUNK = 128;
+    constexpr size_t WRITES = 1 << 15;
+    auto chunk = std::make_shared<std::vector<char>>(CHUNK);
+    for (auto& c : *chunk) c = static_cast<char>('a' + rng() % 26);
+    auto writer = std::make_shared<std::unique_ptr<logF::MMapFileWriter>>();
+    kernels.push_back({"mmap_writer.write", WRITES,
+        [dir, writer] {
+            writer->reset();
+            std::filesystem::remove_all(dir);
+            *writer = std::make_unique<logF::MMapFileWriter>(dir, CHUNK * WRITES * 2);
+            (*writer)->open();
+        },
+        [chunk, writer] {
+            for (size_t i = 0; i < WRITES; ++i) (*writer)->write(chunk->data(), chunk->size());
+            sink = (*writer)->position();
+        }});
+
+    // Consumer 单核格式化吞吐：预先填满环形缓冲区（4 个调用点，整数、浮点和字符串参数），
+    // 计时从启动消费者到全部处理完，包含写入映射文件；停止和关闭文件不计时
+    constexpr size_t DRAIN_MESSAGES = 1 << 18;
+    const std::string drain_dir = (std::filesystem::temp_directory_path() / "logF_micro_drain").string();
+    auto drain_ring = std::make_shared<logF::MpscRingBuffer<logF::LogMessage>>(DRAIN_MESSAGES);
+    auto drain_logger = std::make_shared<logF::Logger<>>(*drain_ring);
+    // 消费者在下一次 setup 或程序退出时停止
+    auto consumer = std::make_shared<std::shared_ptr<logF::Consumer>>();
+    kernels.push_back({"consumer.drain", DRAIN_MESSAGES,
+        [drain_dir, drain_ring, drain_logger, consumer] {
+            consumer->reset();
+            std::filesystem::remove_all(drain_dir);
+            std::filesystem::create_directories(drain_dir);
+            auto& logger = *drain_logger;
+            for (size_t i = 0; i < DRAIN_MESSAGES; i += 4) {
+                const int id = static_cast<int>(i);
+                LOG_INFO(logger, "request % served in % ms", id, 1.25);
+                LOG_INFO(logger, "user % logged in from %", id, "10.0.0.1");
+                LOG_WARNING(logger, "cache miss for key %, retry %", "session", id & 7);
+                LOG_INFO(logger, "queue depth %", id);
+            }
+            consumer->reset(new logF::Consumer(*drain_ring, drain_dir, 64 * 1024 * 1024));
+        },
+        [consumer] {
+            logF::Consumer& c = **consumer;
+            c.start();
+            while (c.get_processed_count() < DRAIN_MESSAGES) std::this_thread::yield();
+            sink = c.get_processed_count();
+        }});
+
+    // lz::compress / lz::decompress：64KB 日志文本块，一次操作为一个块
+    constexpr size_t BLOCK = 64 * 1024;
+    constexpr int BLOCKS = 16;
+    auto text = std::make_shared<std::string>();
+    static const char* words[] = {"request", "user", "latency", "ok", "timeout", "retry", "cache", "miss", "id"};
+    while (text->size() < BLOCK * BLOCKS) {
+        *text += "12:00:00." + std::to_string(100 + rng() % 900) + " [INFO] server.cpp:" + std::to_string(rng() % 400) + " ";
+        for (int w = 0; w < 6; ++w) {
+            *text += words[rng() % 9];
+            *text += (w % 2) ? " " : "=" + std::to_string(rng() % 100000) + " ";
+        }
+        *text += "\n";
+    }
+    auto compressed = std::make_shared<std::vector<std::vector<char>>>(BLOCKS);
+    for (int b = 0; b < BLOCKS; ++b) {
+        auto& out = (*compressed)[b];
+        out.resize(logF::lz::compress_bound(BLOCK));
+        out.resize(logF::lz::compress(text->data() + b * BLOCK, BLOCK, out.data(), out.size()));
+    }
+    auto scratch = std::make_shared<std::vector<char>>(logF::lz::compress_bound(BLOCK));
+    kernels.push_back({"lz.compress_64k", BLOCKS, nullptr,
+        [text, scratch] {
+            uint64_t total = 0;
+            for (int b = 0; b < BLOCKS; ++b) {
+                total += logF::lz::compress(text->data() + b * BLOCK, BLOCK, scratch->data(), scratch->size());
+            }
+            sink = total;
+        }});
+    kernels.push_back({"lz.decompress_64k", BLOCKS, nullptr,
+        [compressed, scratch] {
+            uint64_t total = 0;
+            for (const auto& block : *compressed) {
+                total += logF::lz::decompress(block.data(), block.size(), scratch->data(), BLOCK);
+            }
+            sink = total;
+        }});
+
+    return kernels;
+}
+
+std::map<std::string, double> load_baseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    std::string name;
+    double ns;
+    while (in >> name >> ns) {
+        baseline[name] = ns;
+    }
+    return baseline;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string save_path;
+    std::string check_path;
+    double threshold = 0.3;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--save" && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (arg == "--check" && i + 1 < argc) {
+            check_path = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--save FILE] [--check FILE] [--threshold 0.3]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if (!check_path.empty()) {
+        baseline = load_baseline(check_path);
+        if (baseline.empty()) {
+            std::cout << "No baseline at " << check_path << ", run with --save first. Skipping." << std::endl;
+            return SKIP_RETURN_CODE;
+        }
+    }
+
+    std::ofstream out;
+    if (!save_path.empty()) {
+        out.open(save_path);
+    }
+
+    bool regressed = false;
+    for (const auto& kernel : make_kernels()) {
+        double ns = measure(kernel);
+        std::printf("%-36s %10.2f ns/op", kernel.name.c_str(), ns);
+        auto it = baseline.find(kernel.name);
+        if (it != baseline.end()) {
+            double change = ns / it->second - 1.0;
+            bool failed = change > threshold;
+            regressed |= failed;
+            std::printf("  baseline %10.2f  %+6.1f%%%s", it->second, change * 100.0, failed ? "  REGRESSION" : "");
+        }
+        std::printf("\n");
+        if (out.is_open()) {
+            out << kernel.name << " " << ns << "\n";
+        }
+    }
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "logF_micro_benchmark");
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// 基于 perf_event_open 的硬件计数器，不依赖外部工具。
+// 每个计数器单独打开，内核或虚拟机不支持的计数器读数为空，其余照常工作。
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+namespace bench {
+
+class PerfCounters {
+public:
+    enum Counter { INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, TASK_CLOCK_NS, COUNT };
+
+    using Values = std::array<std::optional<uint64_t>, COUNT>;
+
+    static const char* name(int counter) {
+        static const char* names[COUNT] = {"instructions", "cache_misses", "branch_misses", "task_clock_ns"};
+        return names[counter];
+    }
+
+    // tid 为 0 时统计调用线程，否则统计指定线程
+    explicit PerfCounters(pid_t tid = 0) {
+        fds_[INSTRUCTIONS] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, tid);
+        fds_[CACHE_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, tid);
+        fds_[BRANCH_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, tid);
+        fds_[TASK_CLOCK_NS] = open_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, tid);
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds_) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    void start() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    void stop() {
+        for (int fd : fds_) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    // 计数器被复用时按启用/运行时间比例缩放
+    Values read() const {
+        Values values;
+        for (int i = 0; i < COUNT; ++i) {
+            if (fds_[i] < 0) continue;
+            uint64_t data[3] = {0, 0, 0};  // value, time_enabled, time_running
+            if (::read(fds_[i], data, sizeof(data)) != sizeof(data)) continue;
+            uint64_t value = data[0];
+            if (data[2] != 0 && data[2] < data[1]) {
+                value = static_cast<uint64_t>(static_cast<double>(value) * data[1] / data[2]);
+            }
+            values[i] = value;
+        }
+        return values;
+    }
+
+private:
+    static int open_counter(uint32_t type, uint64_t config, pid_t tid) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+    }
+
+    std::array<int, COUNT> fds_;
+};
+
+// 多线程计数累加，任一线程缺失某计数器则该项为空
+inline void accumulate(PerfCounters::Values& total, const PerfCounters::Values& values, bool first) {
+    for (int i = 0; i < PerfCounters::COUNT; ++i) {
+        if (first) {
+            total[i] = values[i];
+        } else if (total[i] && values[i]) {
+            *total[i] += *values[i];
+        } else {
+            total[i].reset();
+        }
+    }
+}
+
+}
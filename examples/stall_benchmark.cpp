@@ -0,0 +1,351 @@
+// 慢盘压力测试：用注入故障的 sink 代替磁盘写入，测量限速、周期性卡顿和延迟尖刺下的
+// 生产者延迟、丢弃条数和恢复时间。
+//
+// 主日志写到 /dev/shm（没有时写到 logs/stall），本身几乎不花时间；FaultInjectingSink 同步挂在
+// 消费者线程上，它在 flush() 中的阻塞就相当于 MMapFileWriter 遇到慢盘。--async 时用 AsyncSink 包装，
+// 对比记录丢在 sink 前台缓冲区、环形缓冲区不受影响的情况。
+//
+// --check 时只跑一个短场景并核对计数：发送 = 处理 + 丢弃，sink 收到的行数 = 处理数（ctest 使用）
+
+#include "../include/logger.h"
+#include "../include/consumer.h"
+#include "bench_harness.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct FaultProfile {
+    std::string name;
+    double bandwidth_mb = 0;                    // MB/s，0 表示不限速
+    std::chrono::milliseconds stall_every{0};   // 周期性卡顿，0 表示关闭
+    std::chrono::milliseconds stall_for{0};
+    double spike_probability = 0;               // 每次 flush 出现延迟尖刺的概率
+    std::chrono::milliseconds spike_max{0};     // 尖刺时长在 [1ms, spike_max] 内均匀分布
+};
+
+/**
+ * @brief 按故障配置阻塞 flush() 的 sink。卡顿和尖刺的结束时刻记录为故障事件，用于计算恢复时间；
+ * 只在消费者线程上访问，消费者停止后再读取。
+ */
+class FaultInjectingSink : public logF::Sink {
+public:
+    explicit FaultInjectingSink(const FaultProfile& profile)
+        : profile_(profile), next_stall_(Clock::now() + profile.stall_every), rng_(42) {}
+
+    void write(const char* data, size_t len) override {
+        buffer_.append(data, len);
+        lines_ += static_cast<uint64_t>(std::count(data, data + len, '\n'));
+    }
+
+    void flush() override {
+        if (buffer_.empty()) {
+            return;
+        }
+        const auto now = Clock::now();
+        if (profile_.stall_every.count() > 0 && now >= next_stall_) {
+            std::this_thread::sleep_for(profile_.stall_for);
+            fault_ends_.push_back(Clock::now());
+            next_stall_ = Clock::now() + profile_.stall_every;
+        } else if (profile_.spike_probability > 0 && uniform_(rng_) < profile_.spike_probability) {
+            const auto spike = std::chrono::microseconds(
+                1000 + static_cast<int64_t>(uniform_(rng_) * (profile_.spike_max.count() - 1) * 1000));
+            std::this_thread::sleep_for(spike);
+            fault_ends_.push_back(Clock::now());
+        }
+        if (profile_.bandwidth_mb > 0) {
+            // 令牌桶：按累计字节数推算这批数据最早写完的时刻
+            const auto cost = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(buffer_.size() / (profile_.bandwidth_mb * 1024 * 1024)));
+            available_at_ = std::max(available_at_, Clock::now()) + cost;
+            std::this_thread::sleep_until(available_at_);
+        }
+        bytes_ += buffer_.size();
+        buffer_.clear();
+    }
+
+    uint64_t lines() const { return lines_; }
+    uint64_t bytes() const { return bytes_; }
+    const std::vector<Clock::time_point>& fault_ends() const { return fault_ends_; }
+
+private:
+    const FaultProfile profile_;
+    std::string buffer_;
+    uint64_t lines_ = 0;
+    uint64_t bytes_ = 0;
+    Clock::time_point next_stall_;
+    Clock::time_point available_at_{};
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+    std::vector<Clock::time_point> fault_ends_;
+};
+
+struct Options {
+    int threads = 4;
+    uint64_t rate = 100000;           // 每线程每秒消息数
+    double seconds = 3;
+    size_t ring = 1024 * 64;
+    bool async = false;
+    bool check = false;
+    double bandwidth_mb = 20;
+    int stall_ms = 200;
+    int stall_every_ms = 1000;
+    double spike_probability = 0.01;
+    int spike_ms = 50;
+    std::string csv;
+};
+
+struct Result {
+    uint64_t sent = 0;
+    uint64_t dropped = 0;             // 环形缓冲区满，emplace 失败
+    uint64_t processed = 0;
+    uint64_t sink_lines = 0;
+    uint64_t sink_dropped = 0;        // 仅 --async：AsyncSink 前台缓冲区满
+    uint64_t sink_bytes = 0;
+    logF::LatencyHistogram service;   // emplace 调用耗时
+    logF::LatencyHistogram response;  // 从计划发送时刻起算，包含生产者自身被拖慢的时间
+    size_t max_backlog = 0;
+    size_t faults = 0;
+    double recovery_mean_ms = 0;
+    double recovery_max_ms = 0;
+};
+
+// 故障结束后环形缓冲区积压回落到阈值以下所需的时间；积压从未超过阈值的故障恢复时间为 0
+void compute_recovery(const std::vector<std::pair<Clock::time_point, size_t>>& samples,
+                      const std::vector<Clock::time_point>& fault_ends, size_t threshold, Result& result) {
+    double total = 0;
+    for (const auto& end : fault_ends) {
+        auto it = std::lower_bound(samples.begin(), samples.end(), end,
+                                   [](const auto& sample, Clock::time_point t) { return sample.first < t; });
+        double recovery = 0;
+        for (; it != samples.end(); ++it) {
+            if (it->second <= threshold) {
+                recovery = std::chrono::duration<double, std::milli>(it->first - end).count();
+                break;
+            }
+        }
+        if (it == samples.end() && !samples.empty()) {
+            // 测试结束时仍未恢复，按到结束为止计
+            recovery = std::chrono::duration<double, std::milli>(samples.back().first - end).count();
+        }
+        total += recovery;
+        result.recovery_max_ms = std::max(result.recovery_max_ms, recovery);
+    }
+    result.faults = fault_ends.size();
+    result.recovery_mean_ms = fault_ends.empty() ? 0 : total / fault_ends.size();
+}
+
+Result run(const FaultProfile& profile, const Options& options, const std::string& log_dir) {
+    std::filesystem::remove_all(log_dir);
+    std::filesystem::create_directories(log_dir);
+
+    Result result;
+    const double ticks_per_ns = bench::tsc_ticks_per_ns();
+    const uint64_t interval_ticks = static_cast<uint64_t>(1e9 / options.rate * ticks_per_ns);
+    const uint64_t per_thread = static_cast<uint64_t>(options.rate * options.seconds);
+    std::vector<logF::LatencyHistogram> service(options.threads);
+    std::vector<logF::LatencyHistogram> response(options.threads);
+    std::vector<uint64_t> dropped(options.threads, 0);
+    std::vector<std::pair<Clock::time_point, size_t>> samples;
+
+    logF::MpscRingBuffer<logF::LogMessage> ring_buffer(options.ring);
+    logF::Consumer consumer(ring_buffer, log_dir, 1024 * 1024 * 64);
+    auto sink = std::make_unique<FaultInjectingSink>(profile);
+    FaultInjectingSink* fault_sink = sink.get();
+    logF::AsyncSink* async_sink = nullptr;
+    if (options.async) {
+        auto wrapped = std::make_unique<logF::AsyncSink>(std::move(sink));
+        async_sink = wrapped.get();
+        consumer.add_sink(std::move(wrapped));
+    } else {
+        consumer.add_sink(std::move(sink));
+    }
+    consumer.start();
+
+    std::atomic<bool> sampling{true};
+    std::thread monitor([&] {
+        while (sampling.load(std::memory_order_relaxed)) {
+            samples.emplace_back(Clock::now(), ring_buffer.size());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    static logF::CallSite site(logF::file_basename(__FILE__), __LINE__, LOGF_MODULE);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.threads; ++t) {
+        threads.emplace_back([&, t] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {}
+            const uint64_t start = bench::rdtscp();
+            for (uint64_t j = 0; j < per_thread; ++j) {
+                const uint64_t intended = start + j * interval_ticks;
+                while (bench::rdtscp() < intended) {}
+                const uint64_t begin = bench::rdtscp();
+                // 直接调用 emplace 以便统计缓冲区满时的丢弃
+                if (!ring_buffer.emplace(site.id(), logF::LogLevel::INFO, 0u, "Thread %: message %, pi = %",
+                                         t, static_cast<int>(j), 3.14159 + j)) {
+                    ++dropped[t];
+                }
+                const uint64_t end = bench::rdtscp();
+                service[t].record(end - begin);
+                response[t].record(end - intended);
+            }
+        });
+    }
+    while (ready.load() < options.threads) {}
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // 等消费者排空后再停止采样，最后一次故障的恢复也计入
+    while (ring_buffer.size() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sampling.store(false, std::memory_order_relaxed);
+    monitor.join();
+    if (async_sink != nullptr) {
+        result.sink_dropped = async_sink->dropped();
+    }
+    consumer.stop();
+    // 所有 sink 在 consumer 析构前已停止写入，之后读取计数是安全的
+
+    for (int t = 0; t < options.threads; ++t) {
+        result.service.merge(service[t]);
+        result.response.merge(response[t]);
+        result.dropped += dropped[t];
+    }
+    result.sent = per_thread * options.threads;
+    result.processed = consumer.get_processed_count();
+    result.sink_lines = fault_sink->lines();
+    result.sink_bytes = fault_sink->bytes();
+    for (const auto& sample : samples) {
+        result.max_backlog = std::max(result.max_backlog, sample.second);
+    }
+    compute_recovery(samples, fault_sink->fault_ends(), options.ring / 100, result);
+    std::filesystem::remove_all(log_dir);
+    return result;
+}
+
+std::vector<FaultProfile> build_profiles(const Options& options) {
+    const auto stall_for = std::chrono::milliseconds(options.stall_ms);
+    const auto stall_every = std::chrono::milliseconds(options.stall_every_ms);
+    const auto spike_max = std::chrono::milliseconds(std::max(options.spike_ms, 1));
+    std::vector<FaultProfile> profiles;
+    profiles.push_back({"none", 0, {}, {}, 0, {}});
+    profiles.push_back({"bandwidth", options.bandwidth_mb, {}, {}, 0, {}});
+    profiles.push_back({"stall", 0, stall_every, stall_for, 0, {}});
+    profiles.push_back({"spikes", 0, {}, {}, options.spike_probability, spike_max});
+    profiles.push_back({"combined", options.bandwidth_mb, stall_every, stall_for, options.spike_probability, spike_max});
+    return profiles;
+}
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --threads N            producer threads (default 4)\n"
+              << "  --rate N               messages per second per thread (default 100000)\n"
+              << "  --seconds S            duration of each scenario (default 3)\n"
+              << "  --ring N               ring size, power of 2 (default 65536)\n"
+              << "  --bandwidth-mb N       bandwidth cap in MB/s (default 20)\n"
+              << "  --stall-ms N           stall length (default 200)\n"
+              << "  --stall-every-ms N     stall period (default 1000)\n"
+              << "  --spike-p P            per-flush latency spike probability (default 0.01)\n"
+              << "  --spike-ms N           longest spike (default 50)\n"
+              << "  --async                wrap the slow sink in AsyncSink\n"
+              << "  --check                short run that verifies sent = processed + dropped\n"
+              << "  --csv FILE             write results as CSV\n";
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : "0"; };
+        if (arg == "--threads") options.threads = std::clamp(std::stoi(next()), 1, 64);
+        else if (arg == "--rate") options.rate = std::max<uint64_t>(std::stoull(next()), 1);
+        else if (arg == "--seconds") options.seconds = std::stod(next());
+        else if (arg == "--ring") options.ring = std::stoull(next());
+        else if (arg == "--bandwidth-mb") options.bandwidth_mb = std::stod(next());
+        else if (arg == "--stall-ms") options.stall_ms = std::stoi(next());
+        else if (arg == "--stall-every-ms") options.stall_every_ms = std::stoi(next());
+        else if (arg == "--spike-p") options.spike_probability = std::stod(next());
+        else if (arg == "--spike-ms") options.spike_ms = std::stoi(next());
+        else if (arg == "--async") options.async = true;
+        else if (arg == "--check") options.check = true;
+        else if (arg == "--csv") options.csv = next();
+        else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* csv_header() {
+    return "scenario,sink,threads,rate_per_thread,ring_size,sent,processed,dropped,drop_pct,sink_dropped,"
+           "sink_mb_per_sec,service_p50_ns,service_p99_ns,service_p999_ns,service_max_ns,"
+           "response_p50_ns,response_p99_ns,response_p999_ns,response_max_ns,"
+           "max_backlog,faults,recovery_mean_ms,recovery_max_ms";
+}
+
+std::string csv_row(const FaultProfile& profile, const Options& options, const Result& r) {
+    const double ticks_per_ns = bench::tsc_ticks_per_ns();
+    auto ns = [&](uint64_t ticks) { return static_cast<uint64_t>(ticks / ticks_per_ns); };
+    std::ostringstream os;
+    os << profile.name << ',' << (options.async ? "async" : "sync") << ',' << options.threads << ','
+       << options.rate << ',' << options.ring << ',' << r.sent << ',' << r.processed << ',' << r.dropped << ','
+       << (r.sent ? 100.0 * r.dropped / r.sent : 0) << ',' << r.sink_dropped << ','
+       << r.sink_bytes / (1024.0 * 1024.0) / options.seconds << ','
+       << ns(r.service.percentile(50)) << ',' << ns(r.service.percentile(99)) << ','
+       << ns(r.service.percentile(99.9)) << ',' << ns(r.service.max()) << ','
+       << ns(r.response.percentile(50)) << ',' << ns(r.response.percentile(99)) << ','
+       << ns(r.response.percentile(99.9)) << ',' << ns(r.response.max()) << ','
+       << r.max_backlog << ',' << r.faults << ',' << r.recovery_mean_ms << ',' << r.recovery_max_ms;
+    return os.str();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+    const std::string log_dir = std::filesystem::is_directory("/dev/shm") ? "/dev/shm/logF_stall" : "logs/stall";
+
+    if (options.check) {
+        // 小缓冲区 + 卡顿，保证丢弃路径被覆盖
+        options.threads = 2;
+        options.seconds = 1;
+        options.rate = 50000;
+        options.ring = 1024 * 4;
+        options.async = false;
+        FaultProfile profile{"check", 0, std::chrono::milliseconds(300), std::chrono::milliseconds(200), 0, {}};
+        const Result r = run(profile, options, log_dir);
+        std::cout << csv_header() << "\n" << csv_row(profile, options, r) << std::endl;
+        const bool ok = r.sent == r.processed + r.dropped && r.sink_lines == r.processed && r.dropped > 0;
+        if (!ok) {
+            std::cerr << "accounting mismatch: sent " << r.sent << ", processed " << r.processed << ", dropped "
+                      << r.dropped << ", sink lines " << r.sink_lines << std::endl;
+        }
+        return ok ? 0 : 1;
+    }
+
+    std::ofstream csv;
+    if (!options.csv.empty()) {
+        csv.open(options.csv);
+        csv << csv_header() << "\n";
+    }
+    std::cout << csv_header() << std::endl;
+    for (const auto& profile : build_profiles(options)) {
+        const std::string row = csv_row(profile, options, run(profile, options, log_dir));
+        std::cout << row << std::endl;
+        if (csv.is_open()) {
+            csv << row << "\n";
+            csv.flush();
+        }
+    }
+    return 0;
+}
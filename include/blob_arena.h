@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace logF {
+
+class BlobArena;
+
+// LOG_HEX 的负载记录头，负载紧跟其后；LogVariant::BLOB 指向它
+struct BlobHeader {
+    BlobArena* arena;
+    uint64_t end;            // 记录结束处的逻辑偏移，消费者格式化后据此回收
+    uint32_t len;            // 实际复制的字节数
+    uint32_t original_len;   // 调用方传入的长度，超过 MAX_BLOB_BYTES 时大于 len
+
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+};
+
+/**
+ * @brief 线程本地的变长负载区域（单生产者字节环）。生产者只做一次 memcpy；
+ * 同一线程的消息按序被消费，消费者格式化完一条记录就把回收游标推进到它的末尾，
+ * 此前的空间一并可被复用；未能入队的记录由生产者立即撤销。线程退出后区域归还给全局池，不会释放，
+ * 消费者持有的指针始终有效。假设每个线程的日志只由一个消费者处理。
+ */
+class BlobArena {
+public:
+    static constexpr size_t MAX_BLOB_BYTES = 4096;
+
+    // capacity 必须是 2 的幂，且至少能放下一条最大的记录
+    explicit BlobArena(size_t capacity);
+
+    BlobArena(const BlobArena&) = delete;
+    BlobArena& operator=(const BlobArena&) = delete;
+
+    // 生产者线程调用；区域已满时返回 nullptr，该条日志输出 <blob dropped>
+    const BlobHeader* copy(const void* data, size_t len);
+
+    // 生产者线程调用：撤销刚复制、未能入队的记录，否则它之后的空间永远不会被回收
+    void cancel(const BlobHeader* blob);
+
+    // 生产者线程调用：当前有效的复制次数，LogBatch 据此判断区域顺序是否与槽位顺序一致
+    uint64_t copies() const { return copies_; }
+
+    // 消费者线程调用
+    void release(const BlobHeader* blob) { released_.store(blob->end, std::memory_order_release); }
+
+    // 所属线程退出时调用，区域可被新线程复用
+    void release_owner() { in_use_.store(false, std::memory_order_release); }
+
+    static BlobArena& local();
+    // 只影响之后新建的线程区域
+    static void set_per_thread_capacity(size_t capacity);
+
+private:
+    std::unique_ptr<uint8_t[]> buffer_;
+    const size_t mask_;
+    uint64_t head_ = 0;                 // 仅生产者读写
+    uint64_t copies_ = 0;               // 仅生产者读写
+    std::atomic<uint64_t> released_{0};
+    std::atomic<bool> in_use_{false};
+
+    static BlobArena* acquire();
+
+    static std::mutex pool_mutex_;
+    static std::vector<std::unique_ptr<BlobArena>> pool_;
+    static size_t per_thread_capacity_;
+};
+
+}
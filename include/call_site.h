@@ -0,0 +1,135 @@
+#pragma once
+
+#include "log_message.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 每个翻译单元可以在包含 logger.h 之前定义 LOGF_MODULE 作为模块标签
+#ifndef LOGF_MODULE
+#define LOGF_MODULE nullptr
+#endif
+
+namespace logF {
+
+constexpr uint32_t MAX_CALL_SITES = 8192;
+
+// 编译期提取文件名，保证 CallSite 可以常量初始化（没有局部静态变量的 guard 检查）
+constexpr const char* file_basename(const char* path) {
+    const char* base = path;
+    for (const char* p = path; *p != '\0'; ++p) {
+        if (*p == '/') base = p + 1;
+    }
+    return base;
+}
+
+/**
+ * @brief 日志调用点的静态元数据，每个 LOG_* 宏展开处一个实例。
+ * 运行时级别阈值就存放在调用点自身，禁用的日志只需要一次 relaxed load 和一次分支，
+ * 并且不会对参数求值。首次执行时向 CallSiteRegistry 注册并分配 id。
+ */
+class CallSite {
+public:
+    constexpr CallSite(const char* file, uint32_t line, const char* module)
+        : file_(file), module_(module), line_(line) {}
+    // 结构化日志（LOG_KV）：键名是调用点的静态元数据，消息里只带值
+    constexpr CallSite(const char* file, uint32_t line, const char* module, const char* const* keys, uint8_t key_count)
+        : file_(file), module_(module), keys_(keys), line_(line), key_count_(key_count) {}
+    // LOG_HEX：消息带变长负载，消费者格式化前需要预留足够的缓冲区
+    struct Blob {};
+    constexpr CallSite(const char* file, uint32_t line, const char* module, Blob)
+        : file_(file), module_(module), line_(line), has_blob_(true) {}
+
+    CallSite(const CallSite&) = delete;
+    CallSite& operator=(const CallSite&) = delete;
+
+    bool enabled(LogLevel level) {
+        const uint8_t threshold = threshold_.load(std::memory_order_relaxed);
+        if (threshold > static_cast<uint8_t>(level) + 1) {
+            return false;
+        }
+        if (threshold == UNREGISTERED) [[unlikely]] {
+            return register_and_check(level);
+        }
+        // 与注册时的 release 配对，保证 id_ 可见；x86 上不产生指令
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    uint32_t id() const { return id_; }
+    // enabled() 返回 false 后仍需要 id 时使用（飞行记录器）
+    uint32_t acquire_id() const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return id_;
+    }
+    const char* file() const { return file_; }
+    const char* module() const { return module_; }
+    uint32_t line() const { return line_; }
+    const char* const* keys() const { return keys_; }
+    uint8_t key_count() const { return key_count_; }
+    bool has_blob() const { return has_blob_; }
+
+private:
+    friend class CallSiteRegistry;
+
+    static constexpr uint8_t UNREGISTERED = 0;
+
+    bool register_and_check(LogLevel level);
+
+    const char* file_;
+    const char* module_;
+    const char* const* keys_ = nullptr;
+    uint32_t line_;
+    uint32_t id_ = 0;
+    uint8_t key_count_ = 0;
+    bool has_blob_ = false;
+    // 存放 min_level + 1，0 表示尚未注册
+    std::atomic<uint8_t> threshold_{UNREGISTERED};
+};
+
+/**
+ * @brief 调用点注册表，按 id 索引。提供运行时的级别控制接口：
+ * 文件级 > 模块级 > 默认级别，修改立即作用于所有已注册的调用点。
+ */
+class CallSiteRegistry {
+public:
+    static CallSiteRegistry& instance();
+
+    CallSiteRegistry(const CallSiteRegistry&) = delete;
+    CallSiteRegistry& operator=(const CallSiteRegistry&) = delete;
+
+    void set_default_level(LogLevel level);
+    void set_file_level(const std::string& file, LogLevel level);
+    void set_module_level(const std::string& module, LogLevel level);
+    // 清除所有文件级和模块级设置，回到默认级别
+    void clear_overrides();
+    LogLevel default_level() const;
+
+    // 消费者按 id 反查调用点；id 在消息发布前已经注册，无需加锁
+    const CallSite* site(uint32_t id) const { return sites_[id]; }
+    uint32_t size() const { return count_.load(std::memory_order_acquire); }
+
+private:
+    friend class CallSite;
+
+    CallSiteRegistry();
+
+    void register_site(CallSite& site);
+    uint8_t resolve_threshold(const CallSite& site) const;
+    void refresh_thresholds();
+
+    std::array<CallSite*, MAX_CALL_SITES> sites_{};
+    std::atomic<uint32_t> count_{1};  // id 0 保留给未知/溢出的调用点
+    std::vector<CallSite*> overflow_sites_;
+
+    mutable std::mutex mutex_;
+    LogLevel default_level_ = LogLevel::INFO;
+    std::vector<std::pair<std::string, LogLevel>> file_levels_;
+    std::vector<std::pair<std::string, LogLevel>> module_levels_;
+};
+
+}
@@ -4,16 +4,36 @@
 #include "log_message.h"
 #include "ring_buffer.h"
 #include "mmap_writer.h"
+#include "call_site.h"
+#include "flight_recorder.h"
+#include "flush.h"
+#include "latency_tracer.h"
+#include "site_profiler.h"
+#include "lz_block.h"
+#include "sink.h"
+#include "log_context.h"
+#include "blob_arena.h"
+#include "runtime_config.h"
+#include "segment_header.h"
 #include <cstdint>
 #include <string>
 #include <thread>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
 
 namespace logF {
 
 template<uint8_t Level>
 constexpr const char* get_log_level_string() {
-    if constexpr (static_cast<LogLevel>(Level) == LogLevel::INFO) {
+    if constexpr (static_cast<LogLevel>(Level) == LogLevel::TRACE) {
+        return "[TRACE]";
+    } else if constexpr (static_cast<LogLevel>(Level) == LogLevel::DEBUG) {
+        return "[DEBUG]";
+    } else if constexpr (static_cast<LogLevel>(Level) == LogLevel::INFO) {
         return "[INFO]";
     } else if constexpr (static_cast<LogLevel>(Level) == LogLevel::WARNING) {
         return "[WARNING]";
@@ -25,13 +45,96 @@ constexpr const char* get_log_level_string() {
 class Consumer {
 public:
     Consumer(MpscRingBuffer<LogMessage>& ring_buffer, const std::string& log_dir, size_t mmap_file_size = 1024 * 1024 * 16);
+    // 析构时先 stop()
+    ~Consumer();
     void start();
+    // 处理完已发布的消息和已入队的 flush 屏障后返回；之后 Logger::flush() 直接失败，直到再次 start()
     void stop();
     uint64_t get_processed_count() const { return message_count_; }
+    // 消费者线程的内核线程 id，线程启动前为 0（用于性能计数器、调度设置等）
+    pid_t thread_id() const { return thread_id_.load(std::memory_order_acquire); }
+
+    // 时间窗口内同一调用点、参数相同的连续消息合并为一行 "repeated N times"，被合并消息携带的
+    // 限流抑制数累加后附在这一行；0 表示关闭；需在 start() 之前设置
+    void set_coalesce_window(std::chrono::milliseconds window) { coalesce_window_ = window; }
+
+    // 每 N 条消息采样一条端到端延迟（排队/格式化/写入），0 表示关闭；需在 start() 之前设置
+    void set_latency_sampling(uint32_t sample_every) { tracer_.set_sample_every(sample_every); }
+    // 最近发布的延迟直方图，可在任意线程调用
+    LatencyTracer::Snapshot latency_snapshot() const { return tracer_.snapshot(); }
+
+    // 按调用点统计消息数、字节数和格式化耗时，每个周期（空闲时也会）把 top-N 追加写入 stats_path；
+    // 可与延迟采样同时开启。需在 start() 之前设置
+    bool enable_site_profiler(const std::string& stats_path,
+                              std::chrono::milliseconds interval = std::chrono::seconds(10),
+                              size_t top_n = 20) {
+        return profiler_.enable(stats_path, interval, top_n);
+    }
+
+    // 轮转与保留策略，需在 start() 之前设置；删除和压缩旧段在后台低优先级线程中进行
+    void set_rotate_interval(RotateInterval interval) { mmap_writer_.set_rotate_interval(interval); }
+    void set_retention(const RetentionPolicy& policy) { mmap_writer_.set_retention(policy); }
+
+    // 按 block_size 字节分块压缩后写入 .logz 段（帧格式见 lz_block.h，可用 logF_decode 解码）；需在 start() 之前设置。
+    // block_size 需小于格式化缓冲区容量，段大小需大于一个块
+    bool enable_compression(size_t block_size = 64 * 1024);
+
+    // 每约 interval 字节在段旁的 .idx 中记录一个条目（偏移、首时间戳、各级别计数），读取见 SegmentIndex；
+    // 压缩段每个块一个条目。需在 start() 之前设置
+    void enable_index(size_t interval = 64 * 1024);
+
+    // start() 时并行检查日志目录，修复写入进程已退出、未正常关闭的段（见 recover_segments），默认开启；需在 start() 之前设置
+    void set_startup_recovery(bool enabled) { startup_recovery_ = enabled; }
+
+    // 需在 start() 之前设置
+    void set_output_format(OutputFormat format) { output_format_ = format; }
+    void set_wait_strategy(WaitStrategy strategy, std::chrono::microseconds idle_sleep = std::chrono::milliseconds(1)) {
+        wait_strategy_ = strategy;
+        idle_sleep_ = idle_sleep;
+    }
+
+    // 运行时配置：start() 时应用一次，之后消费者在每批消息之间检查版本号，变化时取新快照应用。
+    // store 的生命周期需覆盖消费者；需在 start() 之前设置
+    void attach_config(ConfigStore& store) { config_store_ = &store; }
+
+    // 主日志文件之外的输出目标；每条记录只格式化一次，按各 sink 的级别分发同一段字节。需在 start() 之前添加
+    void add_sink(std::unique_ptr<Sink> sink) { sinks_.push_back(std::move(sink)); }
 
 private:
     void run();
+    void apply_config();
+    void process_batch(const MpscRingBuffer<LogMessage>::ReadView& view);
+    void process(const LogMessage& msg);
+    void handle_control(const LogMessage& msg);
+    // 消费者析构时释放没有被处理的控制消息的负载，未完成的 flush 句柄标记为失败
+    void discard_control(const LogMessage& msg);
     void format_log(const LogMessage& msg);
+    void flush_buffer();
+    void write_compressed_block();
+    void mark_index(const LogMessage& msg);
+    void profile_format(const LogMessage& msg);
+
+    void register_context(const ContextRecord& record);
+    struct SiteFormat;
+    const SiteFormat& site_format(uint32_t site_id, const char* format);
+    void append_prefix(std::chrono::system_clock::time_point timestamp, uint8_t level, const SiteFormat& site,
+                       uint16_t context_id);
+    template<bool Escape> void append_body(const LogMessage& msg, const SiteFormat& format);
+    template<bool Escape> void append_arg(const LogVariant& arg);
+    template<bool Escape> void append_text(const char* data, size_t len);
+    void append_kv_text(const LogMessage& msg, const CallSite* site);
+    void append_json_value(const LogVariant& arg);
+    void append_blob(const BlobHeader* blob);
+    void append_json_prefix(std::chrono::system_clock::time_point timestamp, uint8_t level, const CallSite* site,
+                            uint16_t context_id);
+    void format_json(const LogMessage& msg, const CallSite* site);
+    void dispatch_to_sinks(uint8_t level, size_t record_start);
+    void flush_sinks();
+    bool is_repeat(const LogMessage& msg) const;
+    bool coalesce(const LogMessage& msg);
+    void flush_repeats();
+    // on_error 为 true 时每个窗口最多转储一次，避免 ERROR 密集时反复扫描所有线程
+    void dump_flight_recorder(std::chrono::system_clock::time_point event_time, bool on_error);
     
     // 非原子变量
     MpscRingBuffer<LogMessage>& ring_buffer_;
@@ -39,9 +142,67 @@ private:
     std::thread thread_;
     uint64_t message_count_ = 0;
     CharRingBuffer char_buffer_;
+    const CallSiteRegistry& call_sites_;
+    OutputFormat output_format_ = OutputFormat::TEXT;
+    std::vector<std::unique_ptr<Sink>> sinks_;
+    bool startup_recovery_ = true;
+
+    WaitStrategy wait_strategy_ = WaitStrategy::SLEEP;
+    std::chrono::microseconds idle_sleep_{1000};
+    ConfigStore* config_store_ = nullptr;
+    uint64_t config_version_ = 0;
+
+    // 调用点的预渲染信息，按调用点 id 索引，首次格式化该调用点时生成
+    struct SiteFormat {
+        const char* format = nullptr;   // 切分时的格式串；消息带的格式串不同时按通用路径逐字符解析
+        std::string location;           // "server.cpp:88 "
+        // 格式串按前 MAX_LOG_ARGS 个 % 切开：pieces 个字面段，段之间依次插入参数
+        std::array<uint32_t, MAX_LOG_ARGS + 1> piece_begin{};
+        std::array<uint32_t, MAX_LOG_ARGS + 1> piece_len{};
+        uint8_t pieces = 0;
+    };
+    std::vector<SiteFormat> site_formats_;
+
+    // 线程上下文缓存，按编号索引；注册时渲染好文本和 JSON 两种片段
+    struct RenderedContext {
+        std::string text;  // "[worker-1 req=42] "
+        std::string json;  // ,"thread":"worker-1","req":"42"
+    };
+    std::vector<RenderedContext> contexts_;
+
+    // 重复消息合并
+    std::chrono::milliseconds coalesce_window_{0};
+    LogMessage last_msg_;
+    bool has_last_msg_ = false;
+    uint32_t repeat_count_ = 0;
+    uint64_t repeat_suppressed_ = 0;  // 被合并的重复消息各自携带的限流抑制数之和
+    std::chrono::system_clock::time_point last_repeat_time_;
+
+    // 飞行记录器转储
+    FlightRecorder& recorder_;
+    std::vector<LogMessage> recorder_records_;
+    std::chrono::system_clock::time_point last_dump_time_;
+
+    LatencyTracer tracer_;
+    SiteProfiler profiler_;
+
+    // LOG_HEX 记录格式化前至少要空出的缓冲区：十六进制负载加上前缀和格式串
+    static constexpr size_t BLOB_RESERVE = 2 * BlobArena::MAX_BLOB_BYTES + 512;
+
+    // 块压缩
+    size_t flush_threshold_;
+    bool compress_ = false;
+    std::vector<char> block_buffer_;
+    std::chrono::system_clock::time_point block_first_ts_{};
+
+    // 稀疏索引：标记的 offset 为格式化缓冲区内的偏移，写出时由 MMapFileWriter 换算为段内偏移
+    size_t index_interval_ = 0;
+    size_t next_mark_at_ = 0;
+    std::vector<IndexEntry> index_marks_;
     
     // 原子变量64字节对齐
     alignas(64) std::atomic<bool> running_ = false;
+    std::atomic<pid_t> thread_id_{0};
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "log_message.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace logF {
+
+/**
+ * @brief 单个线程的 TRACE/DEBUG 环形记录，只有所属线程写入。
+ * 每个槽位用 seqlock 保护，消费者转储时可以并发读取而不阻塞写入线程。
+ */
+class RecorderBuffer {
+public:
+    explicit RecorderBuffer(size_t capacity);
+
+    template<typename... Args>
+    void push(uint32_t site_id, LogLevel level, const char* format, Args&&... args) {
+        Slot& slot = slots_[head_ & mask_];
+        const uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);  // 奇数：写入中
+        std::atomic_thread_fence(std::memory_order_release);
+        new (&slot.msg) LogMessage(site_id, level, 0u, format, std::forward<Args>(args)...);
+        slot.seq.store(seq + 2, std::memory_order_release);
+        newest_ns_.store(slot.msg.timestamp.time_since_epoch().count(), std::memory_order_relaxed);
+        ++head_;
+    }
+
+    // 消费者调用：把时间戳在 (from, to] 内、读取时未被覆盖的记录追加到 out
+    void collect(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to,
+                 std::vector<LogMessage>& out) const;
+
+    // 所属线程退出时调用，缓冲区可被新线程复用
+    void release() { in_use_.store(false, std::memory_order_release); }
+
+private:
+    friend class FlightRecorder;
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        LogMessage msg;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    uint64_t head_ = 0;
+    std::atomic<int64_t> newest_ns_{0};  // 最新记录的时间戳，转储时据此跳过过期的缓冲区
+    std::atomic<bool> in_use_{false};
+};
+
+/**
+ * @brief 飞行记录器：被运行时级别过滤掉的 TRACE/DEBUG 日志只写入线程本地的环形记录，
+ * 不格式化也不落盘。记录 ERROR、调用 trigger_dump() 或收到信号时，
+ * 消费者把最近一段时间窗口内的记录格式化写出。
+ * 注意字符串参数会在转储时才读取，必须保证其生命周期足够长（例如字面量）。
+ */
+class FlightRecorder {
+public:
+    static FlightRecorder& instance();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    static bool active() { return active_.load(std::memory_order_relaxed); }
+
+    // per_thread_capacity 必须是 2 的幂，只影响之后新建的线程缓冲区
+    void configure(size_t per_thread_capacity, std::chrono::milliseconds window);
+    void set_active(bool active) { active_.store(active, std::memory_order_relaxed); }
+    std::chrono::milliseconds window() const { return std::chrono::milliseconds(window_ms_.load(std::memory_order_relaxed)); }
+
+    template<typename... Args>
+    static void record(uint32_t site_id, LogLevel level, const char* format, Args&&... args) {
+        local_buffer().push(site_id, level, format, std::forward<Args>(args)...);
+    }
+
+    // 请求一次转储，异步信号安全
+    static void trigger_dump() { dump_requested_.store(true, std::memory_order_release); }
+    static bool take_dump_request() {
+        return dump_requested_.load(std::memory_order_relaxed) &&
+               dump_requested_.exchange(false, std::memory_order_acquire);
+    }
+    static bool install_signal_handler(int signo = SIGUSR1);
+
+    // 消费者调用：收集所有线程 (from, to] 内的记录并按时间排序
+    void collect(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to,
+                 std::vector<LogMessage>& out);
+
+private:
+    FlightRecorder() = default;
+
+    static RecorderBuffer& local_buffer();
+    RecorderBuffer* acquire_buffer();
+
+    static std::atomic<bool> active_;
+    static std::atomic<bool> dump_requested_;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<RecorderBuffer>> buffers_;
+    size_t per_thread_capacity_ = 4096;
+    std::atomic<int64_t> window_ms_{5000};  // 消费者线程无锁读取
+};
+
+}
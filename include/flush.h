@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace logF {
+
+// 一次 flush 请求的完成状态，由生产者的 FlushHandle 和消费者共享
+class FlushState {
+public:
+    explicit FlushState(bool sync) : sync_(sync) {}
+
+    bool sync() const { return sync_; }
+    bool done() const { return done_.load(std::memory_order_acquire); }
+    bool failed() const { return failed_.load(std::memory_order_acquire); }
+
+    // 屏障没能进入环形缓冲区：立即就绪并标记失败
+    void fail() {
+        failed_.store(true, std::memory_order_release);
+        complete();
+    }
+
+    // 消费者调用
+    void complete() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_.store(true, std::memory_order_release);
+        }
+        cv_.notify_all();
+    }
+
+    void wait() {
+        if (done()) return;
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return done(); });
+    }
+
+    template<typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) {
+        if (done()) return true;
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this] { return done(); });
+    }
+
+private:
+    const bool sync_;
+    std::atomic<bool> done_{false};
+    std::atomic<bool> failed_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+/**
+ * @brief Logger::flush() 返回的句柄。在调用 flush() 之前发布的所有消息
+ * 都已格式化并写入 mmap（sync 时还完成了 msync）后变为就绪。
+ */
+class FlushHandle {
+public:
+    FlushHandle() = default;
+    explicit FlushHandle(std::shared_ptr<FlushState> state) : state_(std::move(state)) {}
+
+    bool valid() const { return state_ != nullptr; }
+    bool ready() const { return !state_ || state_->done(); }
+    // 就绪但没有刷新：环形缓冲区一直是满的，屏障没有送达消费者
+    bool failed() const { return state_ && state_->failed(); }
+    void wait() const { if (state_) state_->wait(); }
+
+    template<typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+        return !state_ || state_->wait_for(timeout);
+    }
+
+private:
+    std::shared_ptr<FlushState> state_;
+};
+
+}
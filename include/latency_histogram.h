@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace logF {
+
+/**
+ * @brief HDR 风格的对数-线性直方图：每个 2 的幂区间再等分为 64 个子桶，
+ * 相对误差小于 1/64，记录是 O(1) 且不分配内存。
+ * record_corrected() 按 HdrHistogram 的方式补偿协调遗漏（coordinated omission）。
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 7;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;
+    static constexpr uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t value) {
+        ++counts_[index_of(value)];
+        ++total_;
+        sum_ += value;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+
+    // 若一次操作耗时超过预期间隔，则补记被阻塞期间本应发出的请求
+    void record_corrected(uint64_t value, uint64_t expected_interval);
+
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return total_; }
+    uint64_t min() const { return total_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0.0; }
+    // percentile 取值 [0, 100]，返回所在子桶的上界
+    uint64_t percentile(double percentile) const;
+
+    static size_t index_of(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<size_t>(value);
+        }
+        const int msb = 63 - __builtin_clzll(value);
+        const int shift = msb - (SUB_BUCKET_BITS - 1);
+        const uint64_t mantissa = value >> shift;  // [SUB_BUCKET_HALF, SUB_BUCKET_COUNT)
+        return static_cast<size_t>(SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF + (mantissa - SUB_BUCKET_HALF));
+    }
+
+    static uint64_t upper_bound_of(size_t index);
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> counts_;
+    uint64_t total_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
+}
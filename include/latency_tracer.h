@@ -0,0 +1,64 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace logF {
+
+/**
+ * @brief 端到端延迟采样：每 N 条消息取一条，记录
+ * 入队（消息时间戳）→ 消费者取出 → 格式化完成 → 写入 mmap 三段耗时，单位纳秒。
+ * 只由消费者线程记录；snapshot() 可在任意线程调用，返回最近发布的副本。
+ */
+class LatencyTracer {
+public:
+    struct Snapshot {
+        LatencyHistogram queueing;    // 入队 → 取出
+        LatencyHistogram formatting;  // 取出 → 格式化完成
+        LatencyHistogram io;          // 格式化完成 → 写入 mmap
+    };
+
+    // 0 表示关闭
+    void set_sample_every(uint32_t n) { sample_every_ = n; }
+    bool enabled() const { return sample_every_ != 0; }
+
+    bool should_sample() {
+        if (++counter_ < sample_every_) {
+            return false;
+        }
+        counter_ = 0;
+        return true;
+    }
+
+    static int64_t now_ns() {
+        return to_ns(std::chrono::system_clock::now());
+    }
+    static int64_t to_ns(std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    }
+
+    void record_formatted(int64_t enqueued_ns, int64_t dequeued_ns, int64_t formatted_ns);
+    // 字符缓冲区写入 mmap 后调用，结算所有等待写入的采样
+    void record_written();
+    // 把当前直方图发布给 snapshot()
+    void publish();
+
+    Snapshot snapshot() const;
+
+private:
+    static uint64_t clamp(int64_t delta) { return delta > 0 ? static_cast<uint64_t>(delta) : 0; }
+
+    uint32_t sample_every_ = 0;
+    uint32_t counter_ = 0;
+    std::vector<int64_t> pending_formatted_ns_;
+    Snapshot live_;
+    int64_t last_publish_ns_ = 0;
+
+    mutable std::mutex mutex_;
+    Snapshot published_;
+};
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "log_message.h"
+#include "mpsc_ring_buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace logF {
+
+// 上下文变化时发给消费者的快照，由消费者渲染进缓存后释放
+struct ContextRecord {
+    uint16_t id;
+    std::string thread_name;
+    std::vector<std::pair<std::string, std::string>> fields;
+};
+
+/**
+ * @brief 线程局部的日志上下文（线程名 + 嵌套的 key=value）。
+ * 上下文每变化一次，只在该线程下一次写日志时通过控制消息向消费者注册一次；之后每条消息
+ * 只携带 16 位编号，前缀由消费者从缓存中渲染。LogContext 退出作用域时直接恢复外层的编号，不重新注册。
+ * 编号按全局代数循环使用，距注册超过半个周期的编号会在下次使用前重新注册，避免与新上下文冲突。
+ */
+class ThreadContext {
+public:
+    // 日志热路径：当前线程没有上下文时只有一次线程局部读取
+    static uint16_t id_for(MpscRingBuffer<LogMessage>& ring) {
+        State& s = state();
+        if (!s.active) [[likely]] {
+            return 0;
+        }
+        if (s.current.ring == &ring &&
+            generation_.load(std::memory_order_relaxed) - s.current.generation < REFRESH_AFTER) [[likely]] {
+            return s.current.id;
+        }
+        return register_context(s, ring);
+    }
+
+    static void set_thread_name(std::string name);
+    static const std::string& thread_name() { return state().name; }
+
+    static void push(std::string key, std::string value);
+    static void pop();
+
+private:
+    static constexpr uint64_t ID_SPACE = 65535;  // 0 保留为“无上下文”
+    static constexpr uint64_t REFRESH_AFTER = ID_SPACE / 2;
+
+    struct Registration {
+        const void* ring = nullptr;
+        uint16_t id = 0;
+        uint64_t generation = 0;
+    };
+
+    struct State {
+        std::string name;
+        std::vector<std::pair<std::string, std::string>> fields;
+        std::vector<Registration> saved;  // 每层 push 之前的注册，pop 时恢复
+        Registration current;
+        bool active = false;
+    };
+
+    static State& state() {
+        thread_local State s;
+        return s;
+    }
+
+    static uint16_t register_context(State& s, MpscRingBuffer<LogMessage>& ring);
+
+    static std::atomic<uint64_t> generation_;
+};
+
+inline void set_thread_name(std::string name) {
+    ThreadContext::set_thread_name(std::move(name));
+}
+
+// 用法：logF::LogContext ctx("req", request_id); 作用域内本线程的日志都带 req=<id>
+class LogContext {
+public:
+    template<typename T>
+    LogContext(std::string key, const T& value) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            ThreadContext::push(std::move(key), std::to_string(value));
+        } else {
+            ThreadContext::push(std::move(key), std::string(value));
+        }
+    }
+    ~LogContext() { ThreadContext::pop(); }
+
+    LogContext(const LogContext&) = delete;
+    LogContext& operator=(const LogContext&) = delete;
+};
+
+}
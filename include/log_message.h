@@ -12,33 +12,66 @@ namespace logF {
 constexpr size_t MAX_LOG_ARGS = 4;
 
 enum class LogLevel : uint8_t {
-    INFO = 0,
-    WARNING = 1,
-    ERROR = 2
+    TRACE = 0,
+    DEBUG = 1,
+    INFO = 2,
+    WARNING = 3,
+    ERROR = 4
+};
+
+// 控制消息使用的 level 值：不产生日志输出，由消费者按 ControlType 处理
+constexpr uint8_t CONTROL_LEVEL = 0xFF;
+
+enum class ControlType : uint8_t {
+    FLUSH = 0,
+    CONTEXT = 1,  // 负载为 ContextRecord*，见 log_context.h
+    SKIP = 2      // 批量申请中没有用到的槽，消费者直接跳过
 };
 
 struct LogMessage {
     std::chrono::system_clock::time_point timestamp;  // 8 bytes
-    const char* file;                                 // 8 bytes  
     const char* format;                               // 8 bytes
     std::array<LogVariant, MAX_LOG_ARGS> args;        // 4 * (8 + 1)bytes
-    uint16_t line;                                    // 2 bytes
+    uint32_t site_id;                                 // 4 bytes，文件名和行号见 CallSiteRegistry
     uint8_t level;                                    // 1 byte
     uint8_t num_args;                                 // 1 byte
+    uint16_t context_id;                              // 2 bytes，线程上下文编号，0 表示无
+    uint32_t suppressed;                              // 4 bytes，限流宏在本条之前抑制的条数
 
-    LogMessage() : timestamp(std::chrono::system_clock::now()), file(nullptr), format(""), line(0), level(0), num_args(0) {
+    LogMessage() : timestamp(std::chrono::system_clock::now()), format(""), site_id(0), level(static_cast<uint8_t>(LogLevel::INFO)), num_args(0), context_id(0), suppressed(0) {
         args.fill(LogVariant());
     }
     // 构造函数
    template<typename... Args>
-    LogMessage(const char* file, uint16_t line, LogLevel level, const char* format, Args&&... args)
+    LogMessage(uint32_t site_id, LogLevel level, uint32_t suppressed, const char* format, Args&&... args)
+        : LogMessage(site_id, level, suppressed, uint16_t{0}, format, std::forward<Args>(args)...) {}
+
+    template<typename... Args>
+    LogMessage(uint32_t site_id, LogLevel level, uint32_t suppressed, uint16_t context_id, const char* format, Args&&... args)
         : timestamp(std::chrono::system_clock::now()), 
-          file(file), format(format), line(line), level(static_cast<uint8_t>(level)), num_args(sizeof...(args)) {
+          format(format), site_id(site_id), level(static_cast<uint8_t>(level)), num_args(sizeof...(args)),
+          context_id(context_id), suppressed(suppressed) {
         static_assert(sizeof...(args) <= MAX_LOG_ARGS, "Too many log arguments");
         this->args.fill(LogVariant());
         size_t arg_idx = 0;
         ( (this->args[arg_idx++] = std::forward<Args>(args)), ... );
     }
+    // 控制消息：args[0] 为类型，args[1] 为负载指针
+    LogMessage(ControlType type, const void* payload)
+        : timestamp(std::chrono::system_clock::now()), format(""), site_id(0),
+          level(CONTROL_LEVEL), num_args(2), context_id(0), suppressed(0) {
+        args.fill(LogVariant());
+        args[0] = LogVariant(static_cast<int>(type));
+        args[1] = LogVariant(payload);
+    }
+
+    // MpscRingBuffer::Reservation 提交时填充未用的槽
+    static LogMessage skip() { return LogMessage(ControlType::SKIP, nullptr); }
+
+    bool is_control() const { return level == CONTROL_LEVEL; }
+    ControlType control_type() const { return static_cast<ControlType>(args[0].as_int()); }
 };
 
+static_assert(sizeof(LogMessage) == 64, "LogMessage must fit in one cache line");
+
 }
\ No newline at end of file
@@ -2,13 +2,86 @@
 
 #include "log_message.h"
 #include "mpsc_ring_buffer.h"
+#include "call_site.h"
+#include "rate_limit.h"
+#include "flight_recorder.h"
+#include "flush.h"
+#include "log_context.h"
+#include "blob_arena.h"
+#include <chrono>
 #include <cstdint>
 #include <utility>
 #include <cstring>
+#include <memory>
+#include <thread>
 
 namespace logF {
 
-template<LogLevel MinLevel = LogLevel::INFO>
+/**
+ * @brief 突发日志：一次申请 n 个连续的槽，LOG_* 宏把批次当作 logger 使用，commit()（或析构）时整批发布。
+ *
+ *   auto batch = logger.batch(32);
+ *   for (const auto& level : book) LOG_INFO(batch, "px % qty %", level.px, level.qty);
+ *   batch.commit();
+ *
+ * 整批在输出中连续，不与其他线程的日志交错；n 条只有一次对写游标的 CAS。申请失败（缓冲区空间不足）
+ * 或写满 n 条之后，后续日志退回逐条写入环形缓冲区，满时与 LOG_INFO 一样丢弃。被级别过滤掉的日志不占槽，
+ * 未用的槽在提交时作为跳过消息发布。提交前消费者会停在这批槽上，不要跨越阻塞调用持有批次。
+ */
+template<LogLevel MinLevel>
+class LogBatch {
+public:
+    // 先取上下文编号：首次使用时注册消息要排在这批槽之前
+    LogBatch(MpscRingBuffer<LogMessage>& ring_buffer, size_t n)
+        : ring_buffer_(ring_buffer), context_id_(ThreadContext::id_for(ring_buffer)),
+          blob_copies_(BlobArena::local().copies()), reservation_(ring_buffer.reserve(n)) {}
+
+    static constexpr LogLevel min_level() { return MinLevel; }
+
+    template<typename... Args>
+    void log(LogLevel level, uint32_t site_id, const char* format, Args&&... args) {
+        log_suppressed(level, site_id, 0u, format, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void log_suppressed(LogLevel level, uint32_t site_id, uint32_t suppressed, const char* format, Args&&... args) {
+        if (reservation_.remaining() > 0) [[likely]] {
+            reservation_.emplace(site_id, level, suppressed, context_id_, format, std::forward<Args>(args)...);
+        } else {
+            ring_buffer_.emplace(site_id, level, suppressed, context_id_, format, std::forward<Args>(args)...);
+        }
+    }
+
+    // LOG_HEX 使用：消费者按槽位顺序回收线程区域，负载在区域中的顺序必须与槽位一致。
+    // 批次打开后同一线程在批次之外复制过负载时，这条及之后的负载不再进入预留的槽，改为逐条写入
+    template<typename... Args>
+    void log_blob(LogLevel level, uint32_t site_id, const char* format, const BlobHeader* blob, Args&&... args) {
+        if (blob != nullptr && !blob_out_of_order_) {
+            blob_out_of_order_ = blob->arena->copies() != blob_copies_ + 1;
+            blob_copies_ = blob->arena->copies();
+        }
+        if (reservation_.remaining() > 0 && (blob == nullptr || !blob_out_of_order_)) [[likely]] {
+            reservation_.emplace(site_id, level, 0u, context_id_, format, blob, std::forward<Args>(args)...);
+        } else if (!ring_buffer_.emplace(site_id, level, 0u, context_id_, format, blob, std::forward<Args>(args)...) &&
+                   blob != nullptr) {
+            blob->arena->cancel(blob);
+        }
+    }
+
+    // 申请是否成功；失败时日志逐条写入
+    bool reserved() const { return static_cast<bool>(reservation_); }
+
+    void commit() { reservation_.commit(); }
+
+private:
+    MpscRingBuffer<LogMessage>& ring_buffer_;
+    uint16_t context_id_;
+    uint64_t blob_copies_;             // 批次写入的最后一条负载之后区域的复制次数
+    bool blob_out_of_order_ = false;
+    MpscRingBuffer<LogMessage>::Reservation reservation_;
+};
+
+template<LogLevel MinLevel = LogLevel::TRACE>
 class Logger {
 public:
     explicit Logger(MpscRingBuffer<LogMessage>& ring_buffer) : ring_buffer_(ring_buffer) {}
@@ -16,8 +89,57 @@ public:
     static constexpr LogLevel min_level() { return MinLevel; }
     
     template<typename... Args>
-    void log(LogLevel level, const char* file, int line, const char* format, Args&&... args) {
-        ring_buffer_.emplace(file, static_cast<uint16_t>(line), level, format, std::forward<Args>(args)...);
+    void log(LogLevel level, uint32_t site_id, const char* format, Args&&... args) {
+        ring_buffer_.emplace(site_id, level, 0u, ThreadContext::id_for(ring_buffer_), format,
+                             std::forward<Args>(args)...);
+    }
+
+    // 限流宏使用：附带此前被抑制的条数
+    template<typename... Args>
+    void log_suppressed(LogLevel level, uint32_t site_id, uint32_t suppressed, const char* format, Args&&... args) {
+        ring_buffer_.emplace(site_id, level, suppressed, ThreadContext::id_for(ring_buffer_), format,
+                             std::forward<Args>(args)...);
+    }
+
+    // LOG_HEX 使用：环形缓冲区满、消息被丢弃时撤销负载，区域不会被未入队的记录占满
+    template<typename... Args>
+    void log_blob(LogLevel level, uint32_t site_id, const char* format, const BlobHeader* blob, Args&&... args) {
+        if (!ring_buffer_.emplace(site_id, level, 0u, ThreadContext::id_for(ring_buffer_), format, blob,
+                                  std::forward<Args>(args)...) &&
+            blob != nullptr) {
+            blob->arena->cancel(blob);
+        }
+    }
+
+    // 见 LogBatch
+    LogBatch<MinLevel> batch(size_t n) { return LogBatch<MinLevel>(ring_buffer_, n); }
+
+    /**
+     * @brief 请求消费者追上当前进度。返回的句柄在本次调用之前发布的所有消息
+     * 都已格式化并写入后就绪；sync 为 true 时还会等待 msync 完成。
+     * 屏障作为控制消息进入环形缓冲区，按序列号顺序被处理，调用方无需轮询。
+     * 消费者未启动或已停止时不入队；环形缓冲区在 enqueue_timeout 内一直是满的时放弃。
+     * 这两种情况下返回的句柄立即就绪且 failed() 为 true。消费者停止时会处理完已入队的屏障。
+     */
+    FlushHandle flush(bool sync = false, std::chrono::milliseconds enqueue_timeout = std::chrono::seconds(1)) {
+        auto state = std::make_shared<FlushState>(sync);
+        if (!ring_buffer_.begin_control()) {
+            state->fail();
+            return FlushHandle(std::move(state));
+        }
+        // 消费者处理完后负责释放这份引用
+        auto* token = new std::shared_ptr<FlushState>(state);
+        const auto deadline = std::chrono::steady_clock::now() + enqueue_timeout;
+        while (!ring_buffer_.emplace(ControlType::FLUSH, static_cast<const void*>(token))) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                delete token;
+                state->fail();
+                break;
+            }
+            std::this_thread::yield();
+        }
+        ring_buffer_.end_control();
+        return FlushHandle(std::move(state));
     }
 
 private:
@@ -29,24 +151,120 @@ private:
 // 提取相对路径的宏，避免存储完整的绝对路径
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
-// 编译期判断的日志宏
-#define LOG_INFO(logger, format, ...) \
+// 编译期级别过滤 + 调用点的运行时级别过滤；被过滤时不会对参数求值
+#define LOGF_LOG(logger, level, format, ...) \
+    do { \
+        if constexpr (std::decay_t<decltype(logger)>::min_level() <= level) { \
+            static logF::CallSite logf_call_site_(logF::file_basename(__FILE__), __LINE__, LOGF_MODULE); \
+            if (logf_call_site_.enabled(level)) { \
+                (logger).log(level, logf_call_site_.id(), format, ##__VA_ARGS__); \
+            } \
+        } \
+    } while(0)
+
+// TRACE/DEBUG 被运行时级别过滤时写入飞行记录器，出现 ERROR 时由消费者转储
+#define LOGF_LOG_RECORDED(logger, level, format, ...) \
+    do { \
+        if constexpr (std::decay_t<decltype(logger)>::min_level() <= level) { \
+            static logF::CallSite logf_call_site_(logF::file_basename(__FILE__), __LINE__, LOGF_MODULE); \
+            if (logf_call_site_.enabled(level)) { \
+                (logger).log(level, logf_call_site_.id(), format, ##__VA_ARGS__); \
+            } else if (logF::FlightRecorder::active()) { \
+                logF::FlightRecorder::record(logf_call_site_.acquire_id(), level, format, ##__VA_ARGS__); \
+            } \
+        } \
+    } while(0)
+
+#define LOG_TRACE(logger, format, ...) LOGF_LOG_RECORDED(logger, logF::LogLevel::TRACE, format, ##__VA_ARGS__)
+
+#define LOG_DEBUG(logger, format, ...) LOGF_LOG_RECORDED(logger, logF::LogLevel::DEBUG, format, ##__VA_ARGS__)
+
+#define LOG_INFO(logger, format, ...) LOGF_LOG(logger, logF::LogLevel::INFO, format, ##__VA_ARGS__)
+
+#define LOG_WARNING(logger, format, ...) LOGF_LOG(logger, logF::LogLevel::WARNING, format, ##__VA_ARGS__)
+
+#define LOG_ERROR(logger, format, ...) LOGF_LOG(logger, logF::LogLevel::ERROR, format, ##__VA_ARGS__)
+
+// 结构化日志：LOG_KV(logger, "order_ack", "id", id, "px", px)，最多 4 对键值，键必须是字符串字面量。
+// 事件名和键名放在调用点元数据中，消息只携带值；消费者按 set_output_format() 输出 key=value 文本或 JSON
+#define LOGF_KV_NARGS(...) LOGF_KV_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOGF_KV_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define LOGF_KV_CAT(a, b) LOGF_KV_CAT_(a, b)
+#define LOGF_KV_CAT_(a, b) a##b
+#define LOGF_KV_KEYS(...) LOGF_KV_CAT(LOGF_KV_KEYS_, LOGF_KV_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define LOGF_KV_VALUES(...) LOGF_KV_CAT(LOGF_KV_VALUES_, LOGF_KV_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define LOGF_KV_KEYS_2(k1, v1) k1
+#define LOGF_KV_KEYS_4(k1, v1, k2, v2) k1, k2
+#define LOGF_KV_KEYS_6(k1, v1, k2, v2, k3, v3) k1, k2, k3
+#define LOGF_KV_KEYS_8(k1, v1, k2, v2, k3, v3, k4, v4) k1, k2, k3, k4
+#define LOGF_KV_VALUES_2(k1, v1) v1
+#define LOGF_KV_VALUES_4(k1, v1, k2, v2) v1, v2
+#define LOGF_KV_VALUES_6(k1, v1, k2, v2, k3, v3) v1, v2, v3
+#define LOGF_KV_VALUES_8(k1, v1, k2, v2, k3, v3, k4, v4) v1, v2, v3, v4
+
+#define LOGF_LOG_KV(logger, level, event, ...) \
     do { \
-        if constexpr (decltype(logger)::min_level() <= logF::LogLevel::INFO) { \
-            (logger).log(logF::LogLevel::INFO, __FILENAME__, __LINE__, format, __VA_ARGS__); \
+        if constexpr (std::decay_t<decltype(logger)>::min_level() <= level) { \
+            static constexpr const char* logf_kv_keys_[] = {LOGF_KV_KEYS(__VA_ARGS__)}; \
+            static logF::CallSite logf_call_site_(logF::file_basename(__FILE__), __LINE__, LOGF_MODULE, \
+                                                  logf_kv_keys_, sizeof(logf_kv_keys_) / sizeof(logf_kv_keys_[0])); \
+            if (logf_call_site_.enabled(level)) { \
+                (logger).log(level, logf_call_site_.id(), event, LOGF_KV_VALUES(__VA_ARGS__)); \
+            } \
         } \
     } while(0)
 
-#define LOG_WARNING(logger, format, ...) \
+#define LOG_KV(logger, event, ...) LOGF_LOG_KV(logger, logF::LogLevel::INFO, event, __VA_ARGS__)
+
+// 用法：LOG_KV_AT(logger, WARNING, "order_reject", "id", id, "reason", reason);
+#define LOG_KV_AT(logger, LEVEL, event, ...) LOGF_LOG_KV(logger, logF::LogLevel::LEVEL, event, __VA_ARGS__)
+
+// 二进制负载（例如解码失败的报文）：复制到线程本地区域，格式串中第一个 % 输出为十六进制，
+// 其后的 % 依次对应附加参数（最多 3 个）。超过 BlobArena::MAX_BLOB_BYTES 的部分截断，区域满时输出 <blob dropped>
+#define LOGF_LOG_HEX(logger, level, format, ptr, len, ...) \
     do { \
-        if constexpr (decltype(logger)::min_level() <= logF::LogLevel::WARNING) { \
-            (logger).log(logF::LogLevel::WARNING, __FILENAME__, __LINE__, format, __VA_ARGS__); \
+        if constexpr (std::decay_t<decltype(logger)>::min_level() <= level) { \
+            static logF::CallSite logf_call_site_(logF::file_basename(__FILE__), __LINE__, LOGF_MODULE, \
+                                                  logF::CallSite::Blob{}); \
+            if (logf_call_site_.enabled(level)) { \
+                (logger).log_blob(level, logf_call_site_.id(), format, logF::BlobArena::local().copy(ptr, len), \
+                                  ##__VA_ARGS__); \
+            } \
         } \
     } while(0)
 
-#define LOG_ERROR(logger, format, ...) \
+// 用法：LOG_HEX(logger, "decode failed: % from %", packet, packet_len, peer);
+#define LOG_HEX(logger, format, ptr, len, ...) \
+    LOGF_LOG_HEX(logger, logF::LogLevel::INFO, format, ptr, len, ##__VA_ARGS__)
+#define LOG_HEX_AT(logger, LEVEL, format, ptr, len, ...) \
+    LOGF_LOG_HEX(logger, logF::LogLevel::LEVEL, format, ptr, len, ##__VA_ARGS__)
+
+// 限流与采样：状态是每个调用点、每个线程一份，被抑制的调用不会触碰环形缓冲区
+#define LOGF_LOG_LIMITED(logger, level, should_emit, format, ...) \
     do { \
-        if constexpr (decltype(logger)::min_level() <= logF::LogLevel::ERROR) { \
-            (logger).log(logF::LogLevel::ERROR, __FILENAME__, __LINE__, format, __VA_ARGS__); \
+        if constexpr (std::decay_t<decltype(logger)>::min_level() <= level) { \
+            static logF::CallSite logf_call_site_(logF::file_basename(__FILE__), __LINE__, LOGF_MODULE); \
+            if (logf_call_site_.enabled(level)) { \
+                static thread_local logF::RateLimitState logf_rate_state_; \
+                if (logf_rate_state_.should_emit) { \
+                    (logger).log_suppressed(level, logf_call_site_.id(), logf_rate_state_.take_suppressed(), \
+                                            format, ##__VA_ARGS__); \
+                } else { \
+                    logf_rate_state_.suppress(); \
+                } \
+            } \
         } \
     } while(0)
+
+// 用法：LOG_EVERY_N(logger, WARNING, 1000, "queue full, size %", size);
+#define LOG_EVERY_N(logger, LEVEL, n, format, ...) \
+    LOGF_LOG_LIMITED(logger, logF::LogLevel::LEVEL, every_n(n), format, ##__VA_ARGS__)
+
+#define LOG_FIRST_N(logger, LEVEL, n, format, ...) \
+    LOGF_LOG_LIMITED(logger, logF::LogLevel::LEVEL, first_n(n), format, ##__VA_ARGS__)
+
+#define LOG_EVERY_T(logger, LEVEL, ms, format, ...) \
+    LOGF_LOG_LIMITED(logger, logF::LogLevel::LEVEL, every_t(ms), format, ##__VA_ARGS__)
+
+#define LOG_SAMPLED(logger, LEVEL, p, format, ...) \
+    LOGF_LOG_LIMITED(logger, logF::LogLevel::LEVEL, sampled(p), format, ##__VA_ARGS__)
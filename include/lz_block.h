@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace logF {
+
+/**
+ * @brief 无依赖的 LZ77 块压缩（LZ4 风格的字节序列格式）。
+ * 每个序列为：token（高 4 位字面量长度，低 4 位匹配长度 - 4），长度为 15 时后跟 255 累加的扩展字节，
+ * 字面量，2 字节小端偏移，最后一个序列只有字面量。窗口 64KB，贪心匹配，单遍哈希。
+ */
+namespace lz {
+
+constexpr size_t MIN_MATCH = 4;
+
+inline size_t compress_bound(size_t len) { return len + len / 255 + 16; }
+
+// 返回压缩后的字节数；dst 空间不足时返回 0
+size_t compress(const char* src, size_t len, char* dst, size_t capacity);
+
+// 解压到恰好 out_len 字节，输入损坏或长度不符时返回 false，不会越界读写
+bool decompress(const char* src, size_t len, char* dst, size_t out_len);
+
+}
+
+/**
+ * @brief 压缩段中的块帧：头部之后紧跟 compressed_len 字节的数据。
+ * 每个块独立压缩，带未压缩长度和块内第一条日志的时间戳，可以从任意块开始并行解压。
+ * 段文件末尾未写入的部分为 0，magic 不匹配即表示结束。
+ */
+struct BlockHeader {
+    uint32_t magic;
+    uint32_t flags;
+    uint32_t uncompressed_len;
+    uint32_t compressed_len;
+    int64_t first_timestamp_ns;
+};
+static_assert(sizeof(BlockHeader) == 24, "BlockHeader is part of the on-disk format");
+
+constexpr uint32_t BLOCK_MAGIC = 0x3142464C;  // "LFB1"
+constexpr uint32_t BLOCK_RAW = 1;             // 压缩无收益时原样存储
+
+// 把 len 字节编码为一个完整的块帧写入 dst（至少 sizeof(BlockHeader) + lz::compress_bound(len) 字节），返回帧长度
+size_t encode_block(const char* src, size_t len, int64_t first_timestamp_ns, char* dst);
+
+// 解码 payload 到 dst（至少 header.uncompressed_len 字节）
+bool decode_block(const BlockHeader& header, const char* payload, char* dst);
+
+}
@@ -9,9 +9,15 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <memory>
+#include "retention.h"
+#include "segment_index.h"
 
 namespace logF {
 
+// 按时间轮转；与按大小轮转同时生效，先到者触发
+enum class RotateInterval : uint8_t { NONE, HOURLY, DAILY };
+
 class MMapFileWriter {
 public:
     explicit MMapFileWriter(const std::string& log_dir, size_t file_size = 1024 * 1024 * 16); // 16MB default
@@ -27,12 +33,35 @@ public:
     
     bool open();
     void close();
+
+    // 需在 open() 之前设置。HOURLY 的文件名为 YYYY-MM-DD_HH_<index>.log，其余为 YYYY-MM-DD_<index>.log，
+    // index 在日期（或小时）变化时从 0 开始，并跳过目录中已存在的段
+    void set_rotate_interval(RotateInterval interval) { rotate_interval_ = interval; }
+    // 段文件扩展名，默认 ".log"；需在 open() 之前设置
+    void set_file_extension(const std::string& extension) { extension_ = extension; }
+    // 需在 open() 之前设置，启动后台保留线程
+    void set_retention(const RetentionPolicy& policy);
     
     // Write data to the memory-mapped file
     bool write(const char* data, size_t len);
+    // 同时写出索引：marks[i].offset 为相对 data 的偏移，写入后换算为段内偏移追加到当前段的 .idx
+    bool write(const char* data, size_t len, IndexEntry* marks, size_t mark_count);
+
+    // 每个段旁写 <segment>.idx 稀疏索引；需在 open() 之前设置
+    void enable_index(bool enabled) { index_enabled_ = enabled; }
+
+    // 运行时修改：段大小在下一次轮转（或 open）时生效
+    void set_file_size(size_t file_size) { next_file_size_ = file_size; }
+    size_t file_size() const { return next_file_size_; }
+    // 运行时修改：已打开时立即结束当前段，在新目录中打开新段；保留策略随之切换到新目录
+    bool set_log_dir(const std::string& log_dir);
+    const std::string& log_dir() const { return log_dir_; }
     
     // Flush pending writes to disk
     void flush();
+
+    // Synchronously flush written data to disk (msync MS_SYNC)
+    void sync();
     
     // Get current write position
     size_t position() const { return write_pos_; }
@@ -43,6 +72,9 @@ public:
 private:
     void generate_new_filepath();
     bool rotate_file();
+    int next_free_index(const char* period) const;
+    void open_index();
+    void append_index(const IndexEntry* entries, size_t count);
 
     std::string log_dir_;
     std::string current_filepath_;
@@ -50,7 +82,16 @@ private:
     int fd_ = -1;
     char* mapped_memory_ = nullptr;
     size_t file_size_ = 0;
+    size_t next_file_size_ = 0;
     size_t write_pos_ = 0;
+
+    RotateInterval rotate_interval_ = RotateInterval::NONE;
+    std::chrono::system_clock::time_point next_rotation_ = std::chrono::system_clock::time_point::max();
+    char current_period_[16] = {};
+    std::string extension_ = ".log";
+    bool index_enabled_ = false;
+    int index_fd_ = -1;
+    std::unique_ptr<RetentionManager> retention_;
 };
 
 }
\ No newline at end of file
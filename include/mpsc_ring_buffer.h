@@ -11,6 +11,9 @@
 #include <iterator> // for std::iterator traits
 #include <new>      // for placement new
 #include <type_traits> // for std::is_trivially_destructible_v
+#include <mutex>
+#include <stdexcept>
+#include <sys/mman.h>
 
 /**
  * @brief 基于 LMAX Disruptor 思想的多生产者、单消费者无锁环形缓冲区。
@@ -18,12 +21,32 @@
  * @tparam T 存储在缓冲区中的元素类型。
  */
 namespace logF {
+
+#ifdef LOGF_COUNT_CAS_FAILURES
+// 基准测试用：当前线程 emplace 中 CAS 失败的次数，默认不编译
+inline thread_local uint64_t emplace_cas_failures = 0;
+#endif
+
+/**
+ * @brief 弹性模式的配置：起步只有 initial_slots 个槽，生产者追上消费者时按段接入新的槽，
+ * 总内存（含每槽 8 字节的发布序号）不超过 max_bytes；段被消费者读完后归还到池中，
+ * 缓冲区排空且 1 秒内没有再扩展时，把超出起步大小的空闲段交还给操作系统。
+ */
+struct ElasticRingConfig {
+    size_t segment_slots = 4096;           // 每段槽数，2 的幂
+    size_t initial_slots = 16384;          // 常驻的槽数，按段向上取整
+    size_t max_bytes = 64 * 1024 * 1024;   // 内存预算，至少两段
+};
+
 template<typename T>
 class MpscRingBuffer {
 public:
     class ReadView;
+    class Reservation;
 
+    // 固定容量，capacity 必须是 2 的幂
     explicit MpscRingBuffer(size_t capacity);
+    explicit MpscRingBuffer(const ElasticRingConfig& config);
     ~MpscRingBuffer();
 
     // Non-copyable, non-movable
@@ -38,8 +61,40 @@ public:
     template<typename... Args>
     bool emplace(Args&&... args);
 
+    /**
+     * @brief (多线程安全) 用一次 CAS 申请 n 个连续的槽，由返回的 Reservation 依次构造、一次提交。
+     * 整批在消费者处连续出现，不与其他生产者的消息交错。空间不足时返回空的 Reservation，不做部分申请。
+     * 提交之前消费者读不到这些槽之后的任何消息，申请后应尽快提交，不要跨越阻塞调用持有。
+     */
+    Reservation reserve(size_t n);
+
     ReadView read();
 
+    // 屏障类控制消息（Logger::flush）的发送方在入队前后调用。消费者未运行时 begin_control() 返回 false，
+    // 屏障不会留在缓冲区中无人完成；消费者停止时先标记未运行，等发送方都离开后再处理完剩余消息
+    bool begin_control() {
+        control_senders_.fetch_add(1, std::memory_order_seq_cst);
+        if (!consumer_running_.load(std::memory_order_seq_cst)) {
+            control_senders_.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+    void end_control() { control_senders_.fetch_sub(1, std::memory_order_release); }
+    void set_consumer_running(bool running) { consumer_running_.store(running, std::memory_order_seq_cst); }
+    bool control_senders_idle() const { return control_senders_.load(std::memory_order_seq_cst) == 0; }
+
+    // 最多可容纳的未消费消息数
+    size_t capacity() const { return capacity_; }
+    // 已申请但尚未被消费者读走的消息数（近似值，监控用）
+    size_t size() const {
+        // 先读 read_cursor_，保证差值不为负
+        const uint64_t read = read_cursor_.load(std::memory_order_acquire);
+        return static_cast<size_t>(write_cursor_.load(std::memory_order_acquire) - read);
+    }
+    // 当前占用的段内存（含池中空闲段）
+    size_t memory_bytes() const { return allocated_segments_.load(std::memory_order_relaxed) * segment_bytes_; }
+
     class ReadView {
     public:
         class iterator {
@@ -51,7 +106,7 @@ public:
             using reference = T&;
 
             reference operator*() const {
-                return *reinterpret_cast<T*>(&buffer_->buffer_[current_seq_ & buffer_->capacity_mask_]);
+                return *buffer_->slot(current_seq_);
             }
             pointer operator->() const { return &operator*(); }
             iterator& operator++() { ++current_seq_; return *this; }
@@ -98,11 +153,10 @@ public:
             if (buffer_) {
                 if constexpr (!std::is_trivially_destructible_v<T>) {
                     for (uint64_t i = begin_seq_; i < end_seq_; ++i) {
-                        T* obj_ptr = reinterpret_cast<T*>(&buffer_->buffer_[i & buffer_->capacity_mask_]);
-                        obj_ptr->~T();
+                        buffer_->slot(i)->~T();
                     }
                 }
-                buffer_->read_cursor_.store(end_seq_, std::memory_order_release);
+                buffer_->advance_read(begin_seq_, end_seq_);
             }
         }
 
@@ -111,15 +165,131 @@ public:
         uint64_t end_seq_;
     };
 
+    class Reservation {
+    public:
+        Reservation() = default;
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+        Reservation(Reservation&& other) noexcept
+            : buffer_(other.buffer_), begin_(other.begin_), next_(other.next_), end_(other.end_) {
+            other.buffer_ = nullptr;
+        }
+        Reservation& operator=(Reservation&& other) noexcept {
+            if (this != &other) {
+                commit();
+                buffer_ = other.buffer_;
+                begin_ = other.begin_;
+                next_ = other.next_;
+                end_ = other.end_;
+                other.buffer_ = nullptr;
+            }
+            return *this;
+        }
+        // 未提交的申请在析构时提交，消费者不会停在没有发布的槽上
+        ~Reservation() { commit(); }
+
+        explicit operator bool() const { return buffer_ != nullptr; }
+        // 还可以构造的槽数
+        size_t remaining() const { return buffer_ ? end_ - next_ : 0; }
+
+        // 在下一个槽中构造对象；槽已用完或申请失败时返回 false
+        template<typename... Args>
+        bool emplace(Args&&... args) {
+            if (next_ == end_ || buffer_ == nullptr) {
+                return false;
+            }
+            new (buffer_->slot(next_)) T(std::forward<Args>(args)...);
+            ++next_;
+            return true;
+        }
+
+        // 未用的槽填入 T::skip()，再从后往前写发布序号：第一个槽最后发布，消费者一次看到整批
+        void commit() {
+            if (buffer_ == nullptr) {
+                return;
+            }
+            for (; next_ != end_; ++next_) {
+                new (buffer_->slot(next_)) T(T::skip());
+            }
+            for (uint64_t seq = end_; seq-- != begin_;) {
+                buffer_->sequence(seq).store(seq, std::memory_order_release);
+            }
+            buffer_ = nullptr;
+        }
+
+    private:
+        friend class MpscRingBuffer<T>;
+        Reservation(MpscRingBuffer<T>* buffer, uint64_t begin_seq, uint64_t end_seq)
+            : buffer_(buffer), begin_(begin_seq), next_(begin_seq), end_(end_seq) {}
+
+        MpscRingBuffer<T>* buffer_ = nullptr;
+        uint64_t begin_ = 0;
+        uint64_t next_ = 0;
+        uint64_t end_ = 0;
+    };
+
 private:
     using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
 
+    // 一段连续的槽和对应的发布序号，整段用一次匿名 mmap 分配，释放时直接归还操作系统
+    struct Segment {
+        std::atomic<uint64_t>* sequences;
+        Storage* slots;
+        Segment* next_free;
+    };
+
+    static size_t segment_bytes_for(size_t slots) {
+        return 64 + slots * sizeof(std::atomic<uint64_t>) + slots * sizeof(Storage);
+    }
+
+    MpscRingBuffer(size_t segment_slots, size_t table_size, size_t capacity, size_t retained_segments,
+                   size_t max_segments, bool elastic);
+
+    // 序号 seq 所在的段；弹性模式下生产者可能先于段接入拿到序号，此时返回 nullptr
+    Segment* segment_for(uint64_t seq) const {
+        return table_[(seq >> segment_shift_) & table_mask_].load(std::memory_order_acquire);
+    }
+    T* slot(uint64_t seq) const {
+        if (!elastic_) [[likely]] {
+            return reinterpret_cast<T*>(&fixed_slots_[seq & segment_mask_]);
+        }
+        return reinterpret_cast<T*>(&segment_for(seq)->slots[seq & segment_mask_]);
+    }
+
+    std::atomic<uint64_t>& sequence(uint64_t seq) const {
+        if (!elastic_) [[likely]] {
+            return fixed_sequences_[seq & segment_mask_];
+        }
+        return segment_for(seq)->sequences[seq & segment_mask_];
+    }
+
+    Segment* attach(uint64_t seq);
+    void advance_read(uint64_t begin_seq, uint64_t end_seq);
+    Segment* allocate_segment();
+    void free_segment(Segment* segment);
+
     const size_t capacity_;
-    const size_t capacity_mask_;
-    std::unique_ptr<Storage[]> buffer_;
-    
-    // 用于发布写入完成的序列号数组
-    std::unique_ptr<std::atomic<uint64_t>[]> slot_sequences_;
+    const size_t segment_mask_;
+    const size_t segment_shift_;
+    const size_t segment_bytes_;
+    const size_t table_mask_;
+    const bool elastic_;
+    const size_t retained_segments_;
+    const size_t max_segments_;
+
+    // 段表：按序号的高位索引。固定容量时只有一项，始终接入，热路径直接使用下面两个指针
+    std::unique_ptr<std::atomic<Segment*>[]> table_;
+    Storage* fixed_slots_ = nullptr;
+    std::atomic<uint64_t>* fixed_sequences_ = nullptr;
+
+    // 以下只在接入、回收段时使用（慢路径）
+    std::mutex pool_mutex_;
+    Segment* free_segments_ = nullptr;
+    std::atomic<size_t> allocated_segments_{0};
+    std::atomic<int64_t> last_growth_ns_{0};
+    std::atomic<bool> consumer_running_{false};
+    std::atomic<uint32_t> control_senders_{0};
+    static constexpr int64_t SHRINK_AFTER_IDLE_NS = 1000000000;
 
     alignas(64) std::atomic<uint64_t> write_cursor_;
     alignas(64) std::atomic<uint64_t> read_cursor_;
@@ -127,20 +297,58 @@ private:
 
 // --- 实现 ---
 
+namespace detail {
+inline size_t log2_pow2(size_t value) {
+    size_t shift = 0;
+    while ((size_t{1} << shift) < value) ++shift;
+    return shift;
+}
+}
+
 template<typename T>
 MpscRingBuffer<T>::MpscRingBuffer(size_t capacity)
+    : MpscRingBuffer(capacity, 1, capacity, 1, 1, false) {}
+
+template<typename T>
+MpscRingBuffer<T>::MpscRingBuffer(const ElasticRingConfig& config)
+    : MpscRingBuffer(config.segment_slots,
+                     size_t{1} << detail::log2_pow2(config.max_bytes / segment_bytes_for(config.segment_slots)),
+                     // 未消费的区间最多跨 max_segments 段，保证接入时总有段可用
+                     (config.max_bytes / segment_bytes_for(config.segment_slots) - 1) * config.segment_slots,
+                     (config.initial_slots + config.segment_slots - 1) / config.segment_slots,
+                     config.max_bytes / segment_bytes_for(config.segment_slots), true) {}
+
+template<typename T>
+MpscRingBuffer<T>::MpscRingBuffer(size_t segment_slots, size_t table_size, size_t capacity,
+                                  size_t retained_segments, size_t max_segments, bool elastic)
     : capacity_(capacity),
-      capacity_mask_(capacity - 1),
-      buffer_(std::make_unique<Storage[]>(capacity)),
-      slot_sequences_(std::make_unique<std::atomic<uint64_t>[]>(capacity)),
+      segment_mask_(segment_slots - 1),
+      segment_shift_(detail::log2_pow2(segment_slots)),
+      segment_bytes_(segment_bytes_for(segment_slots)),
+      table_mask_(table_size - 1),
+      elastic_(elastic),
+      retained_segments_(retained_segments),
+      max_segments_(max_segments),
+      table_(std::make_unique<std::atomic<Segment*>[]>(table_size)),
       write_cursor_(0),
       read_cursor_(0)
 {
-    if (capacity_ == 0 || (capacity_ & (capacity_ - 1)) != 0) {
+    if (segment_slots == 0 || (segment_slots & (segment_slots - 1)) != 0) {
         throw std::invalid_argument("Capacity must be a power of 2.");
     }
-    for (size_t i = 0; i < capacity_; ++i) {
-        slot_sequences_[i].store(i - capacity_, std::memory_order_relaxed);
+    if (elastic_ && (max_segments_ < 2 || retained_segments_ > max_segments_)) {
+        throw std::invalid_argument("Ring memory budget must hold at least two segments and the initial size.");
+    }
+    for (size_t i = 0; i < table_size; ++i) {
+        table_[i].store(nullptr, std::memory_order_relaxed);
+    }
+    table_[0].store(allocate_segment(), std::memory_order_relaxed);
+    if (!elastic_) {
+        fixed_slots_ = table_[0].load(std::memory_order_relaxed)->slots;
+        fixed_sequences_ = table_[0].load(std::memory_order_relaxed)->sequences;
+    }
+    for (size_t i = 1; i < retained_segments_; ++i) {
+        free_segment(allocate_segment());
     }
 }
 
@@ -150,8 +358,106 @@ MpscRingBuffer<T>::~MpscRingBuffer() {
         const uint64_t write_pos = write_cursor_.load(std::memory_order_relaxed);
         const uint64_t read_pos = read_cursor_.load(std::memory_order_relaxed);
         for (uint64_t i = read_pos; i < write_pos; ++i) {
-            T* obj_ptr = reinterpret_cast<T*>(&buffer_[i & capacity_mask_]);
-            obj_ptr->~T();
+            if (segment_for(i) != nullptr) {
+                slot(i)->~T();
+            }
+        }
+    }
+    for (size_t i = 0; i <= table_mask_; ++i) {
+        if (Segment* segment = table_[i].load(std::memory_order_relaxed)) {
+            munmap(segment, segment_bytes_);
+        }
+    }
+    while (free_segments_ != nullptr) {
+        Segment* next = free_segments_->next_free;
+        munmap(free_segments_, segment_bytes_);
+        free_segments_ = next;
+    }
+}
+
+template<typename T>
+typename MpscRingBuffer<T>::Segment* MpscRingBuffer<T>::allocate_segment() {
+    void* memory = mmap(nullptr, segment_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    auto* segment = static_cast<Segment*>(memory);
+    auto* base = static_cast<char*>(memory) + 64;
+    segment->sequences = reinterpret_cast<std::atomic<uint64_t>*>(base);
+    segment->slots = reinterpret_cast<Storage*>(base + (segment_mask_ + 1) * sizeof(std::atomic<uint64_t>));
+    segment->next_free = nullptr;
+    // 任何序号都不会等于 ~0，读者不会把新段里的槽当成已发布
+    for (size_t i = 0; i <= segment_mask_; ++i) {
+        segment->sequences[i].store(~uint64_t{0}, std::memory_order_relaxed);
+    }
+    allocated_segments_.fetch_add(1, std::memory_order_relaxed);
+    last_growth_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+    return segment;
+}
+
+template<typename T>
+void MpscRingBuffer<T>::free_segment(Segment* segment) {
+    // 回收的段里残留的都是更早的序号，同样不会被误认为已发布
+    segment->next_free = free_segments_;
+    free_segments_ = segment;
+}
+
+template<typename T>
+typename MpscRingBuffer<T>::Segment* MpscRingBuffer<T>::attach(uint64_t seq) {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    auto& entry = table_[(seq >> segment_shift_) & table_mask_];
+    Segment* segment = entry.load(std::memory_order_relaxed);
+    if (segment != nullptr) {
+        return segment;  // 同一段的其他生产者已经接入
+    }
+    if (free_segments_ != nullptr) {
+        segment = free_segments_;
+        free_segments_ = segment->next_free;
+    } else {
+        // 容量按预算计算，这里最多达到 max_segments_
+        segment = allocate_segment();
+    }
+    entry.store(segment, std::memory_order_release);
+    return segment;
+}
+
+template<typename T>
+void MpscRingBuffer<T>::advance_read(uint64_t begin_seq, uint64_t end_seq) {
+    if (!elastic_) [[likely]] {
+        read_cursor_.store(end_seq, std::memory_order_release);
+        return;
+    }
+    if ((begin_seq >> segment_shift_) != (end_seq >> segment_shift_)) {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        // 已经读完的段先摘下再推进读游标，生产者看到新游标时段一定已经在池中
+        for (uint64_t s = begin_seq >> segment_shift_; s < (end_seq >> segment_shift_); ++s) {
+            free_segment(table_[s & table_mask_].exchange(nullptr, std::memory_order_relaxed));
+        }
+        const uint64_t pending = write_cursor_.load(std::memory_order_relaxed) - end_seq;
+        if (free_segments_ == nullptr && pending > segment_mask_ &&
+            allocated_segments_.load(std::memory_order_relaxed) < max_segments_) {
+            // 积压超过一段时在消费者线程上预先分配一段，生产者接入时不必等待 mmap
+            free_segment(allocate_segment());
+        }
+    }
+    read_cursor_.store(end_seq, std::memory_order_release);
+
+    // 排空并且一段时间内没有再扩展时，把超出常驻大小的空闲段还给操作系统；
+    // 连续的突发之间不反复 mmap/munmap
+    if (allocated_segments_.load(std::memory_order_relaxed) > retained_segments_ &&
+        write_cursor_.load(std::memory_order_relaxed) == end_seq) [[unlikely]] {
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (now - last_growth_ns_.load(std::memory_order_relaxed) < SHRINK_AFTER_IDLE_NS) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        while (free_segments_ != nullptr && allocated_segments_.load(std::memory_order_relaxed) > retained_segments_) {
+            Segment* segment = free_segments_;
+            free_segments_ = segment->next_free;
+            munmap(segment, segment_bytes_);
+            allocated_segments_.fetch_sub(1, std::memory_order_relaxed);
         }
     }
 }
@@ -165,17 +471,60 @@ bool MpscRingBuffer<T>::emplace(Args&&... args) {
         if (current_write_seq - read_cursor_.load(std::memory_order_acquire) >= capacity_) {
             return false;
         }
+#ifdef LOGF_COUNT_CAS_FAILURES
+        ++emplace_cas_failures;
+#endif
     } while (!write_cursor_.compare_exchange_weak(
         current_write_seq, current_write_seq + 1, 
         std::memory_order_release, std::memory_order_relaxed));
+#ifdef LOGF_COUNT_CAS_FAILURES
+    --emplace_cas_failures;  // 成功的那一次不计入
+#endif
 
-    new (&buffer_[current_write_seq & capacity_mask_]) T(std::forward<Args>(args)...);
+    const size_t index = current_write_seq & segment_mask_;
+    Storage* slots = fixed_slots_;
+    std::atomic<uint64_t>* sequences = fixed_sequences_;
+    if (elastic_) [[unlikely]] {
+        Segment* segment = segment_for(current_write_seq);
+        if (segment == nullptr) [[unlikely]] {
+            segment = attach(current_write_seq);
+        }
+        slots = segment->slots;
+        sequences = segment->sequences;
+    }
+    new (&slots[index]) T(std::forward<Args>(args)...);
 
-    slot_sequences_[current_write_seq & capacity_mask_].store(current_write_seq, std::memory_order_release);
+    sequences[index].store(current_write_seq, std::memory_order_release);
     
     return true;
 }
 
+template<typename T>
+typename MpscRingBuffer<T>::Reservation MpscRingBuffer<T>::reserve(size_t n) {
+    if (n == 0 || n > capacity_) {
+        return Reservation();
+    }
+    uint64_t begin_seq;
+    do {
+        begin_seq = write_cursor_.load(std::memory_order_relaxed);
+        if (begin_seq + n - read_cursor_.load(std::memory_order_acquire) > capacity_) {
+            return Reservation();
+        }
+    } while (!write_cursor_.compare_exchange_weak(
+        begin_seq, begin_seq + n,
+        std::memory_order_release, std::memory_order_relaxed));
+
+    if (elastic_) [[unlikely]] {
+        // 申请的区间可能跨段，逐段接入
+        for (uint64_t seq = begin_seq; seq < begin_seq + n; seq = (seq | segment_mask_) + 1) {
+            if (segment_for(seq) == nullptr) {
+                attach(seq);
+            }
+        }
+    }
+    return Reservation(this, begin_seq, begin_seq + n);
+}
+
 template<typename T>
 typename MpscRingBuffer<T>::ReadView MpscRingBuffer<T>::read() {
     const uint64_t current_read = read_cursor_.load(std::memory_order_relaxed);
@@ -184,9 +533,29 @@ typename MpscRingBuffer<T>::ReadView MpscRingBuffer<T>::read() {
     
     uint64_t end_of_batch_seq = current_read;
 
-    // 在 [current_read, write_cursor_snapshot) 范围内查找连续的已发布块
-    while (end_of_batch_seq < write_cursor_snapshot &&
-           (slot_sequences_[end_of_batch_seq & capacity_mask_].load(std::memory_order_acquire) == end_of_batch_seq)) {
+    if (!elastic_) [[likely]] {
+        // 在 [current_read, write_cursor_snapshot) 范围内查找连续的已发布块
+        while (end_of_batch_seq < write_cursor_snapshot &&
+               (fixed_sequences_[end_of_batch_seq & segment_mask_].load(std::memory_order_acquire) == end_of_batch_seq)) {
+            end_of_batch_seq++;
+        }
+        return ReadView(this, current_read, end_of_batch_seq);
+    }
+
+    // 弹性模式：跨段时才重新查段表，段尚未接入视为未发布
+    Segment* segment = nullptr;
+    uint64_t segment_end = end_of_batch_seq;
+    while (end_of_batch_seq < write_cursor_snapshot) {
+        if (end_of_batch_seq == segment_end) {
+            segment = segment_for(end_of_batch_seq);
+            if (segment == nullptr) {
+                break;
+            }
+            segment_end = (end_of_batch_seq | segment_mask_) + 1;
+        }
+        if (segment->sequences[end_of_batch_seq & segment_mask_].load(std::memory_order_acquire) != end_of_batch_seq) {
+            break;
+        }
         end_of_batch_seq++;
     }
 
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "sink.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace logF {
+
+/**
+ * @brief 网络 sink 的批次帧：头部之后紧跟 payload_len 字节，内容为若干条格式化好的记录，
+ * 压缩时为 lz 格式（解压后 raw_len 字节）。sequence 在同一 stream（发送进程）内连续，
+ * 接收端据此发现因缓冲区满而丢弃的批次。
+ */
+struct BatchHeader {
+    uint32_t magic;
+    uint16_t flags;
+    uint16_t reserved;
+    uint32_t payload_len;
+    uint32_t raw_len;
+    uint32_t records;
+    uint32_t stream;
+    uint64_t sequence;
+};
+static_assert(sizeof(BatchHeader) == 32, "BatchHeader is part of the wire format");
+
+constexpr uint32_t BATCH_MAGIC = 0x314E464C;   // "LFN1"
+constexpr uint16_t BATCH_COMPRESSED = 1;
+constexpr uint32_t MAX_BATCH_PAYLOAD = 16 * 1024 * 1024;
+
+// "tcp://host:port" 或 "unix:///path/to.sock"；解析失败时返回 false
+bool resolve_endpoint(const std::string& endpoint, sockaddr_storage& addr, socklen_t& addr_len);
+
+/**
+ * @brief 有界的帧缓冲：mmap 的字节环，帧不跨越末尾（放不下时从头开始，末尾留空）。
+ * 指定 path 时映射到文件，头部记录读写位置，进程重启后继续发送未送出的帧；path 为空时只在内存中。
+ * 只在消费者线程上使用。
+ */
+class FrameSpool {
+public:
+    FrameSpool(const std::string& path, size_t capacity);
+    ~FrameSpool();
+
+    FrameSpool(const FrameSpool&) = delete;
+    FrameSpool& operator=(const FrameSpool&) = delete;
+
+    bool ok() const { return data_ != nullptr; }
+    // 空间不足时返回 false
+    bool push(const BatchHeader& header, const char* payload);
+    // 从最早的帧开始跳过 skip 字节，把剩余的数据填入 iov（最多两段），返回段数
+    int gather(size_t skip, iovec* iov) const;
+    // 最早一帧的长度（含头部），为空时返回 0
+    size_t front_size() const;
+    void pop_front();
+
+    bool empty() const { return meta_->head == meta_->tail; }
+    size_t used() const { return static_cast<size_t>(meta_->tail - meta_->head); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Meta {
+        uint64_t magic;
+        uint64_t capacity;
+        uint64_t head;       // 逻辑偏移，物理位置为 % capacity
+        uint64_t tail;
+        uint64_t pad_start;  // 最近一次回绕时末尾留空的起点，读到这里跳到下一圈
+    };
+
+    size_t capacity_;
+    size_t mapped_bytes_ = 0;
+    char* mapping_ = nullptr;
+    Meta* meta_ = nullptr;
+    char* data_ = nullptr;
+};
+
+struct NetworkSinkOptions {
+    size_t batch_bytes = 64 * 1024;          // 单个批次的最大记录字节数，flush() 时不足也会封批
+    std::string spool_path;                  // 为空时只缓冲在内存中
+    size_t spool_bytes = 64 * 1024 * 1024;
+    bool compress = false;
+    std::chrono::milliseconds reconnect_min{100};
+    std::chrono::milliseconds reconnect_max{10000};
+    std::chrono::milliseconds linger{1000};  // 析构时等待发送剩余数据的最长时间
+};
+
+/**
+ * @brief 把记录按批次通过 TCP 或 Unix 域套接字发送给收集端（参考实现见 tools/logF_collector.cpp）。
+ * 所有批次先写入 FrameSpool，再用 sendmsg 把多帧一次性从 spool 中发出，不再额外复制；
+ * 断开、对端读得慢时帧留在 spool 中，连接恢复后按序补发，spool 满时丢弃新批次并计数。
+ * 断开后按指数退避重连。套接字是非阻塞的，可以直接挂在消费者线程上。
+ */
+class NetworkSink : public Sink {
+public:
+    NetworkSink(const std::string& endpoint, LogLevel level = LogLevel::TRACE, NetworkSinkOptions options = {});
+    ~NetworkSink() override;
+
+    void write(const char* data, size_t len) override;
+    void flush() override;
+
+    bool connected() const { return state_ == State::CONNECTED; }
+    uint64_t dropped() const { return dropped_records_; }
+    uint64_t reconnects() const { return reconnects_; }
+    size_t spooled_bytes() const { return spool_.used(); }
+
+private:
+    enum class State : uint8_t { DISCONNECTED, CONNECTING, CONNECTED };
+
+    void seal_batch();
+    bool try_connect();
+    void disconnect();
+    void send_pending();
+
+    std::string endpoint_;
+    NetworkSinkOptions options_;
+    sockaddr_storage addr_{};
+    socklen_t addr_len_ = 0;
+    bool resolved_ = false;
+
+    std::string batch_;
+    uint32_t batch_records_ = 0;
+    std::vector<char> compressed_;
+    uint32_t stream_;
+    uint64_t sequence_ = 0;
+
+    FrameSpool spool_;
+    size_t sent_in_front_ = 0;   // 最早一帧已发出的字节数；断开时归零，整帧重发
+
+    int fd_ = -1;
+    State state_ = State::DISCONNECTED;
+    std::chrono::milliseconds backoff_;
+    std::chrono::steady_clock::time_point next_connect_{};
+    uint64_t dropped_records_ = 0;
+    uint64_t reconnects_ = 0;
+    bool ever_connected_ = false;
+};
+
+}
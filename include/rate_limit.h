@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace logF {
+
+// 限流宏的状态，位于宏展开处的 thread_local 静态变量中，无需任何同步
+struct RateLimitState {
+    uint64_t counter = 0;
+    int64_t last_emit_ns = 0;
+    uint64_t rng = 0;
+    uint32_t suppressed = 0;
+
+    // n 为 0 时与 1 相同，每次都输出（与 every_t(0) 一致），避免除零
+    bool every_n(uint64_t n) {
+        if (n <= 1) [[unlikely]] {
+            return true;
+        }
+        return counter++ % n == 0;
+    }
+
+    bool first_n(uint64_t n) {
+        if (counter < n) {
+            ++counter;
+            return true;
+        }
+        return false;
+    }
+
+    bool every_t(int64_t interval_ms) {
+        const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (last_emit_ns != 0 && now_ns - last_emit_ns < interval_ms * 1000000) {
+            return false;
+        }
+        last_emit_ns = now_ns;
+        return true;
+    }
+
+    // 以概率 p 输出，xorshift64 生成随机数
+    bool sampled(double p) {
+        if (rng == 0) [[unlikely]] {
+            rng = (reinterpret_cast<uintptr_t>(this) ^ static_cast<uint64_t>(
+                std::chrono::steady_clock::now().time_since_epoch().count())) | 1;
+        }
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return static_cast<double>(rng >> 11) * 0x1.0p-53 < p;
+    }
+
+    void suppress() {
+        if (suppressed != UINT32_MAX) ++suppressed;
+    }
+
+    uint32_t take_suppressed() {
+        const uint32_t count = suppressed;
+        suppressed = 0;
+        return count;
+    }
+};
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace logF {
+
+/**
+ * @brief 日志目录的保留策略：总字节数和文件数上限（0 表示不限），
+ * 以及轮转出的段是否交给外部命令压缩（例如 "gzip -q"，以 "<command> <path>" 方式执行）。
+ */
+struct RetentionPolicy {
+    uint64_t max_total_bytes = 0;
+    size_t max_files = 0;
+    std::string compress_command;
+};
+
+/**
+ * @brief 后台保留线程：以 SCHED_IDLE 和空闲 IO 优先级运行，负责压缩轮转出的段、
+ * 按修改时间从旧到新删除超出预算的段。写入线程只在轮转时入队并唤醒它，不做任何文件操作。
+ * 只处理文件名形如 YYYY-MM-DD*.log* 的段，.idx 索引随段一起删除；当前正在写入的段永远不会被删除或压缩。
+ */
+class RetentionManager {
+public:
+    RetentionManager(std::string log_dir, RetentionPolicy policy);
+    ~RetentionManager();
+
+    RetentionManager(const RetentionManager&) = delete;
+    RetentionManager& operator=(const RetentionManager&) = delete;
+
+    // 写入线程调用：closed_path 为刚关闭的段（可为空），active_path 为新打开的段
+    void on_rotated(const std::string& closed_path, const std::string& active_path);
+    const RetentionPolicy& policy() const { return policy_; }
+
+private:
+    void run();
+    void compress(const std::string& path);
+    void enforce();
+
+    const std::string log_dir_;
+    const RetentionPolicy policy_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> closed_;
+    std::string active_path_;
+    bool pending_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+}
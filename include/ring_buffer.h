@@ -2,10 +2,13 @@
 
 #include <vector>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 
 // Forward declaration
 namespace logF {
     class MMapFileWriter;
+    struct IndexEntry;
 }
 
 namespace logF {
@@ -14,14 +17,36 @@ namespace logF {
 class CharRingBuffer {
 public:
     CharRingBuffer(size_t capacity = 65536); // 64KB default
-    void append(const char* data, size_t len);
+    // 格式化热路径上的两个追加放在头文件中内联
+    void append(const char* data, size_t len) {
+        if (write_pos_ + len >= capacity_) [[unlikely]] {
+            // 不应发生：调用方在格式化每条记录前已检查剩余空间，这里截断
+            len = capacity_ - write_pos_ - 1;
+        }
+        std::memcpy(buffer_.data() + write_pos_, data, len);
+        write_pos_ += len;
+    }
     void append(const char* str);
-    void append(char c);
+    void append(char c) {
+        if (write_pos_ < capacity_ - 1) [[likely]] {
+            buffer_[write_pos_++] = c;
+        }
+    }
     void append_number(long long num);
     void append_number(double num);
+    // 最短的往返表示（std::to_chars），结构化输出使用，不损失精度
+    void append_number_exact(double num);
+    // JSON 字符串转义（不含两侧引号）：SSE2 每次检查 16 字节，整段无需转义时直接复制
+    void append_json_escaped(const char* data, size_t len);
+    void append_json_escaped(const char* str);
+    // 小写十六进制，SSE2 每次编码 16 字节
+    void append_hex(const uint8_t* data, size_t len);
     void flush_to_mmap(MMapFileWriter& writer);
+    void flush_to_mmap(MMapFileWriter& writer, IndexEntry* marks, size_t mark_count);
     void clear();
     size_t size() const { return write_pos_; }
+    size_t capacity() const { return capacity_; }
+    const char* data() const { return buffer_.data(); }
     bool has_space(size_t needed) const { return write_pos_ + needed < capacity_; }
 
 private:
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace logF {
+
+// TEXT：时间 [级别] 文件:行 消息，LOG_KV 为 event key=value；JSON：每行一个对象（JSON Lines）
+enum class OutputFormat : uint8_t { TEXT, JSON };
+
+// 消费者空闲时的等待方式：先自旋若干轮，仍无消息时 SLEEP 休眠 idle_sleep，YIELD 让出 CPU，BUSY_SPIN 继续自旋
+enum class WaitStrategy : uint8_t { SLEEP, YIELD, BUSY_SPIN };
+
+/**
+ * @brief 可在运行时修改的配置。空目录、0 段大小表示保持消费者当前的设置。
+ * 格式与等待方式在下一批消息之前生效；段大小在下一次轮转时生效；目录变化时在下一批之前轮转到新目录。
+ */
+struct RuntimeConfig {
+    std::string log_dir;
+    size_t segment_size = 0;
+    OutputFormat output_format = OutputFormat::TEXT;
+    WaitStrategy wait_strategy = WaitStrategy::SLEEP;
+    std::chrono::microseconds idle_sleep{1000};
+};
+
+/**
+ * @brief RCU 风格的配置发布：写者复制、修改后整体替换快照并递增版本号；
+ * 读者只在每批消息之间读一次版本号，变化时才加锁取新快照，旧快照在最后一个持有者释放后回收。
+ */
+class ConfigStore {
+public:
+    explicit ConfigStore(RuntimeConfig initial = {})
+        : current_(std::make_shared<const RuntimeConfig>(std::move(initial))) {}
+
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    // 任意线程调用
+    void update(RuntimeConfig config) {
+        auto next = std::make_shared<const RuntimeConfig>(std::move(config));
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_ = std::move(next);
+        version_.fetch_add(1, std::memory_order_release);
+    }
+
+    // 在当前配置的副本上修改后发布，例如 store.modify([](RuntimeConfig& c) { c.output_format = OutputFormat::JSON; });
+    template<typename F>
+    void modify(F&& f) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        RuntimeConfig next = *current_;
+        f(next);
+        current_ = std::make_shared<const RuntimeConfig>(std::move(next));
+        version_.fetch_add(1, std::memory_order_release);
+    }
+
+    std::shared_ptr<const RuntimeConfig> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current_;
+    }
+
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const RuntimeConfig> current_;
+    std::atomic<uint64_t> version_{0};
+};
+
+/**
+ * @brief 轮询配置文件（按修改时间和大小判断变化，兼容编辑器先写临时文件再改名的保存方式），
+ * 解析成功后发布到 ConfigStore；解析失败时保留原配置并输出错误。文件格式为每行 key = value，# 开头为注释：
+ *
+ *   log_dir = /var/log/app
+ *   segment_size = 32M          # 支持 K/M/G 后缀
+ *   output_format = json        # text | json
+ *   wait_strategy = sleep       # sleep | yield | spin
+ *   idle_sleep_us = 1000
+ */
+class ConfigFileWatcher {
+public:
+    ConfigFileWatcher(std::string path, ConfigStore& store,
+                      std::chrono::milliseconds interval = std::chrono::seconds(1));
+    ~ConfigFileWatcher();
+
+    ConfigFileWatcher(const ConfigFileWatcher&) = delete;
+    ConfigFileWatcher& operator=(const ConfigFileWatcher&) = delete;
+
+    // 解析配置文件；失败时返回 false，error 为带行号的说明
+    static bool load(const std::string& path, RuntimeConfig& config, std::string& error);
+
+private:
+    void run();
+    void poll();
+
+    const std::string path_;
+    ConfigStore& store_;
+    const std::chrono::milliseconds interval_;
+    int64_t last_mtime_ns_ = -1;
+    int64_t last_size_ = -1;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace logF {
+
+/**
+ * @brief 段文件头：段开头固定 256 字节的一行可打印文本，文本段仍可直接用 cat/less/grep 查看。
+ *
+ *   #logF segment v1 pid=0000012345 created=1760000000123456789 committed=0000000000004096 state=O host=web-1   \n
+ *
+ * 各字段定宽，位置固定。committed 是已完整写入的数据在文件中的结束偏移（含文件头），写入端每批写完后原地更新；
+ * state 为 O（写入中）或 C（已关闭，文件已截断到 committed）。读取端只需读 committed，不必扫描 0 填充的尾部。
+ * 进程崩溃后 state 仍为 O，由 recover_segments() 截断到最后一条完整记录并标记为 C。
+ */
+constexpr size_t SEGMENT_HEADER_SIZE = 256;
+
+struct SegmentInfo {
+    uint32_t version = 0;
+    uint32_t pid = 0;
+    int64_t created_ns = 0;
+    uint64_t committed = 0;
+    bool closed = false;
+    std::string host;
+};
+
+// 在 dst（至少 SEGMENT_HEADER_SIZE 字节）写入 state=O、committed=SEGMENT_HEADER_SIZE 的文件头
+void format_segment_header(char* dst, int64_t created_ns);
+
+// 原地更新 committed；一次 16 字节的 memcpy
+void store_segment_committed(char* header, uint64_t committed);
+void store_segment_closed(char* header);
+
+// 不是段文件头（例如旧格式的段）时返回 false
+bool parse_segment_header(const char* data, size_t size, SegmentInfo& info);
+
+struct RecoveryStats {
+    size_t scanned = 0;       // 带文件头的段
+    size_t recovered = 0;     // 截断并标记为已关闭的段
+    size_t skipped_live = 0;  // 写入进程仍在运行（或在其他主机上）的段
+    uint64_t trimmed_bytes = 0;
+};
+
+/**
+ * @brief 并行检查目录中的段：state=O 且写入进程已不存在（同一 pid 的进程启动晚于段的创建时刻也算不存在，
+ * 例如容器重启后的 pid 1）的段截断到最后一条完整的记录（文本段）或完整的块帧
+ * （.logz 段），同时丢弃 .idx 中越界的条目，最后标记为已关闭。force 时不检查写入进程（用于从其他主机拷来的段）。
+ * Consumer::start() 在打开新段之前对日志目录调用一次。
+ */
+RecoveryStats recover_segments(const std::string& log_dir, unsigned threads = 0, bool force = false,
+                               bool dry_run = false);
+
+}
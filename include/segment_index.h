@@ -0,0 +1,63 @@
+#pragma once
+
+#include "log_message.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace logF {
+
+constexpr size_t LOG_LEVEL_COUNT = 5;
+
+/**
+ * @brief 段旁的稀疏索引 <segment>.idx：16 字节文件头之后是定长条目，
+ * 每个条目覆盖段内从 offset 开始、到下一条目为止的字节（压缩段中为一个块帧）。
+ */
+struct IndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_size;
+    uint32_t reserved;
+};
+
+struct IndexEntry {
+    uint64_t offset;
+    int64_t first_timestamp_ns;
+    uint32_t level_counts[LOG_LEVEL_COUNT];
+    uint32_t reserved;
+};
+static_assert(sizeof(IndexHeader) == 16 && sizeof(IndexEntry) == 40, "index entries are part of the on-disk format");
+
+constexpr uint32_t INDEX_MAGIC = 0x3149464C;  // "LFI1"
+constexpr uint32_t INDEX_VERSION = 1;
+
+inline std::string index_path_for(const std::string& segment_path) { return segment_path + ".idx"; }
+
+/**
+ * @brief 索引读取：按时间二分查找条目，或按级别计数的前缀和跳到下一个含 ERROR 等记录的条目，均为 O(log n)。
+ * 多个生产者的时间戳只是近似有序，seek() 按条目首时间戳的前缀最大值查找，结果偏保守，调用方从返回的条目开始扫描并过滤。
+ */
+class SegmentIndex {
+public:
+    // 读取 segment_path 对应的 .idx；segment_size 为段文件长度，用于计算最后一个条目的结束位置
+    bool load(const std::string& segment_path, uint64_t segment_size);
+
+    const std::vector<IndexEntry>& entries() const { return entries_; }
+    size_t size() const { return entries_.size(); }
+
+    // 可能包含时间戳 >= timestamp_ns 的第一个条目
+    size_t seek(int64_t timestamp_ns) const;
+    // 从条目 from 开始（含）第一个包含 level 级别记录的条目，没有则返回 size()
+    size_t next_with_level(size_t from, LogLevel level) const;
+
+    uint64_t begin_offset(size_t i) const { return entries_[i].offset; }
+    uint64_t end_offset(size_t i) const { return i + 1 < entries_.size() ? entries_[i + 1].offset : segment_size_; }
+
+private:
+    std::vector<IndexEntry> entries_;
+    std::vector<int64_t> max_timestamp_;                 // 首时间戳的前缀最大值
+    std::vector<uint64_t> level_prefix_[LOG_LEVEL_COUNT]; // level_prefix_[l][i] = 前 i 个条目中 l 级别的记录数
+    uint64_t segment_size_ = 0;
+};
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "log_message.h"
+#include "mmap_writer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace logF {
+
+/**
+ * @brief 日志输出目标。消费者只格式化一次，把同一段格式化好的字节（只读、仅在调用期间有效）
+ * 交给每个级别允许的 sink；sink 自行缓冲，flush() 在批次边界和消费者空闲时调用。
+ * write()/flush() 都在消费者线程上执行，可能阻塞的 sink 应该用 AsyncSink 包装。
+ */
+class Sink {
+public:
+    explicit Sink(LogLevel level = LogLevel::TRACE) : level_(static_cast<uint8_t>(level)) {}
+    virtual ~Sink() = default;
+
+    Sink(const Sink&) = delete;
+    Sink& operator=(const Sink&) = delete;
+
+    bool accepts(uint8_t level) const { return level >= level_; }
+    LogLevel level() const { return static_cast<LogLevel>(level_); }
+
+    virtual void write(const char* data, size_t len) = 0;
+    virtual void flush() {}
+
+private:
+    uint8_t level_;
+};
+
+// 独立目录或扩展名下的 mmap 段文件，例如只收 ERROR 的 "logs/error"
+class FileSink : public Sink {
+public:
+    FileSink(const std::string& log_dir, LogLevel level, size_t file_size = 1024 * 1024 * 16,
+             const std::string& extension = ".log");
+
+    void write(const char* data, size_t len) override { buffer_.append(data, len); }
+    void flush() override;
+
+private:
+    MMapFileWriter writer_;
+    std::string buffer_;
+};
+
+// 开发时输出到终端
+class ConsoleSink : public Sink {
+public:
+    explicit ConsoleSink(LogLevel level = LogLevel::TRACE, int fd = 1) : Sink(level), fd_(fd) {}
+
+    void write(const char* data, size_t len) override { buffer_.append(data, len); }
+    void flush() override;
+
+private:
+    int fd_;
+    std::string buffer_;
+};
+
+// 本地 Unix 域套接字（SOCK_STREAM），非阻塞发送；对端读得慢时保留最多 max_pending 字节，超出的记录丢弃并计数，
+// 断开后每秒重连一次
+class UnixSocketSink : public Sink {
+public:
+    UnixSocketSink(const std::string& path, LogLevel level = LogLevel::TRACE, size_t max_pending = 4 * 1024 * 1024);
+    ~UnixSocketSink() override;
+
+    void write(const char* data, size_t len) override;
+    void flush() override;
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    bool connect();
+
+    std::string path_;
+    size_t max_pending_;
+    int fd_ = -1;
+    std::string pending_;
+    uint64_t dropped_ = 0;
+    std::chrono::steady_clock::time_point next_connect_{};
+};
+
+/**
+ * @brief 把慢 sink 放到独立线程：消费者只把字节追加到前台缓冲区（持锁时间只有一次 memcpy），
+ * 后台线程交换缓冲区后写给内部 sink。前台缓冲区满时丢弃新记录并计数，不会阻塞消费者和其他 sink。
+ */
+class AsyncSink : public Sink {
+public:
+    explicit AsyncSink(std::unique_ptr<Sink> inner, size_t buffer_bytes = 4 * 1024 * 1024);
+    ~AsyncSink() override;
+
+    void write(const char* data, size_t len) override;
+    void flush() override;
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    std::unique_ptr<Sink> inner_;
+    const size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::string front_;
+    std::string back_;
+    bool stopping_ = false;
+    std::atomic<uint64_t> dropped_{0};
+    std::thread thread_;
+};
+
+}
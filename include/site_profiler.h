@@ -0,0 +1,79 @@
+#pragma once
+
+#include "call_site.h"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace logF {
+
+/**
+ * @brief 按调用点（文件、行号、格式串）统计日志量，用于找出刷屏的 LOG_* 调用。
+ * 只在消费者线程中使用；按 site id 直接索引，同一调用点出现不同格式串时退化到哈希表。
+ * 每个周期把消息数、字节数和格式化耗时的 top-N 追加写入单独的统计文件，然后清零。
+ */
+class SiteProfiler {
+public:
+    explicit SiteProfiler(const CallSiteRegistry& call_sites) : call_sites_(call_sites) {}
+
+    bool enable(const std::string& stats_path, std::chrono::milliseconds interval, size_t top_n);
+    bool enabled() const { return enabled_; }
+
+    void record(uint32_t site_id, const char* format, size_t bytes, uint64_t format_ns) {
+        Entry& entry = entry_for(site_id, format);
+        ++entry.count;
+        entry.bytes += bytes;
+        entry.format_ns += format_ns;
+    }
+
+    // 到达周期时写出报告
+    void maybe_report(std::chrono::steady_clock::time_point now) {
+        if (now >= next_report_) [[unlikely]] {
+            report();
+            next_report_ = now + interval_;
+        }
+    }
+    void report();
+
+private:
+    struct Entry {
+        uint32_t site_id = 0;
+        const char* format = nullptr;
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+        uint64_t format_ns = 0;
+    };
+
+    struct KeyHash {
+        size_t operator()(const std::pair<uint32_t, const char*>& key) const {
+            return std::hash<const void*>()(key.second) ^ (static_cast<size_t>(key.first) * 0x9E3779B97F4A7C15ULL);
+        }
+    };
+
+    Entry& entry_for(uint32_t site_id, const char* format) {
+        Entry& entry = by_site_[site_id];
+        if (entry.format == format || entry.format == nullptr) [[likely]] {
+            entry.site_id = site_id;
+            entry.format = format;
+            return entry;
+        }
+        Entry& other = overflow_[{site_id, format}];
+        other.site_id = site_id;
+        other.format = format;
+        return other;
+    }
+
+    const CallSiteRegistry& call_sites_;
+    bool enabled_ = false;
+    std::vector<Entry> by_site_;
+    std::unordered_map<std::pair<uint32_t, const char*>, Entry, KeyHash> overflow_;
+    std::ofstream out_;
+    std::chrono::milliseconds interval_{0};
+    std::chrono::steady_clock::time_point next_report_;
+    size_t top_n_ = 20;
+};
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+
+namespace logF {
+
+struct TimeCache {
+    int64_t cached_milliseconds = 0;
+    char cached_time_str[32] = {0};  // MM-DD HH:MM:SS.sss 格式预留足够空间
+    size_t cached_len = 0;
+    
+    // 只在毫秒变化时重新格式化时间字符串
+    void update_time_string(const std::chrono::system_clock::time_point& timestamp) {
+        // 获取毫秒级时间戳
+        auto ms_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+            timestamp.time_since_epoch()).count();
+        
+        if (ms_since_epoch == cached_milliseconds) return;
+        
+        auto seconds_since_epoch = ms_since_epoch / 1000;
+        int milliseconds = static_cast<int>(ms_since_epoch - seconds_since_epoch * 1000);
+        
+        std::time_t seconds = static_cast<std::time_t>(seconds_since_epoch);
+        
+        // 获取本地时间
+        std::tm* local_tm = std::localtime(&seconds);
+        
+        // 使用strftime格式化基本时间部分
+        char base_time[16];
+        std::strftime(base_time, sizeof(base_time), "%H:%M:%S", local_tm);
+        
+        // 添加毫秒部分
+        const int len = std::snprintf(cached_time_str, sizeof(cached_time_str),
+                                      "%s.%03d", base_time, milliseconds);
+        cached_len = len > 0 ? std::min(static_cast<size_t>(len), sizeof(cached_time_str) - 1) : 0;
+        
+        cached_milliseconds = ms_since_epoch;
+    }
+};
+
+}
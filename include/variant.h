@@ -4,32 +4,43 @@
 
 namespace logF {
 
+struct BlobHeader;
+
 // 紧凑的LogVariant，使用packed减少大小
 struct __attribute__((packed)) LogVariant {
     enum Type : uint8_t {
         INT = 0,
         DOUBLE = 1, 
-        CSTR = 2
+        CSTR = 2,
+        POINTER = 3,
+        BLOB = 4      // LOG_HEX 负载，见 blob_arena.h
     };
     
     union {
         int64_t i;
         double d;
         const char* s;
+        const void* p;
+        const BlobHeader* b;
     } data;
     
     Type type;
     
     LogVariant() : type(INT) { data.i = 0; }
     LogVariant(int val) : type(INT) { data.i = val; }
-    LogVariant(long val) : type(INT) { data.i = static_cast<int32_t>(val); }
+    LogVariant(long val) : type(INT) { data.i = val; }
     LogVariant(double val) : type(DOUBLE) { data.d = val; }
     LogVariant(const char* val) : type(CSTR) { data.s = val; }
+    // 只供控制消息携带负载；explicit 保证 LOG_* 传入 int*、Foo* 等指针时仍然编译失败
+    explicit LogVariant(const void* val) : type(POINTER) { data.p = val; }
+    LogVariant(const BlobHeader* val) : type(BLOB) { data.b = val; }
     
     // 访问方法
-    int32_t as_int() const { return data.i; }
+    int64_t as_int() const { return data.i; }
     double as_double() const { return data.d; }
     const char* as_cstr() const { return data.s; }
+    const void* as_pointer() const { return data.p; }
+    const BlobHeader* as_blob() const { return data.b; }
     Type get_type() const { return type; }
 };
 
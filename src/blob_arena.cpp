@@ -0,0 +1,91 @@
+#include "../include/blob_arena.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace logF {
+
+std::mutex BlobArena::pool_mutex_;
+std::vector<std::unique_ptr<BlobArena>> BlobArena::pool_;
+size_t BlobArena::per_thread_capacity_ = 1024 * 1024;
+
+namespace {
+// 记录头 8 字节对齐
+size_t record_size(size_t copied) {
+    return (sizeof(BlobHeader) + copied + 7) & ~size_t{7};
+}
+}
+
+BlobArena::BlobArena(size_t capacity)
+    : buffer_(new uint8_t[capacity]), mask_(capacity - 1) {}
+
+const BlobHeader* BlobArena::copy(const void* data, size_t len) {
+    const size_t copied = len < MAX_BLOB_BYTES ? len : MAX_BLOB_BYTES;
+    const size_t need = record_size(copied);
+    uint64_t start = head_;
+    const size_t offset = start & mask_;
+    if (offset + need > mask_ + 1) {
+        start += mask_ + 1 - offset;  // 记录不跨越末尾，剩余部分随下一条一起回收
+    }
+    if (start + need - released_.load(std::memory_order_acquire) > mask_ + 1) [[unlikely]] {
+        return nullptr;
+    }
+    auto* header = reinterpret_cast<BlobHeader*>(buffer_.get() + (start & mask_));
+    header->arena = this;
+    header->end = start + need;
+    header->len = static_cast<uint32_t>(copied);
+    header->original_len = static_cast<uint32_t>(len);
+    std::memcpy(header + 1, data, copied);
+    head_ = header->end;
+    ++copies_;
+    return header;
+}
+
+void BlobArena::cancel(const BlobHeader* blob) {
+    if (blob->end != head_) {
+        return;  // 只能撤销最近一次复制
+    }
+    // 为避免跨越末尾而跳过的尾部不回退，随下一条记录一起回收
+    head_ = blob->end - record_size(blob->len);
+    --copies_;
+}
+
+namespace {
+// 线程退出时归还区域，新线程可以复用
+struct LocalArenaHandle {
+    BlobArena* arena = nullptr;
+    ~LocalArenaHandle() {
+        if (arena) arena->release_owner();
+    }
+};
+}
+
+BlobArena& BlobArena::local() {
+    thread_local LocalArenaHandle handle;
+    if (handle.arena == nullptr) [[unlikely]] {
+        handle.arena = acquire();
+    }
+    return *handle.arena;
+}
+
+void BlobArena::set_per_thread_capacity(size_t capacity) {
+    if (capacity < sizeof(BlobHeader) + MAX_BLOB_BYTES || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("Blob arena capacity must be a power of 2 and hold one full blob.");
+    }
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    per_thread_capacity_ = capacity;
+}
+
+BlobArena* BlobArena::acquire() {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    for (auto& arena : pool_) {
+        if (arena->mask_ + 1 == per_thread_capacity_ &&
+            !arena->in_use_.exchange(true, std::memory_order_acquire)) {
+            return arena.get();
+        }
+    }
+    pool_.push_back(std::make_unique<BlobArena>(per_thread_capacity_));
+    pool_.back()->in_use_.store(true, std::memory_order_relaxed);
+    return pool_.back().get();
+}
+
+}
@@ -0,0 +1,115 @@
+#include "../include/call_site.h"
+#include <cstring>
+
+namespace logF {
+
+namespace {
+// id 0：注册表溢出时所有调用点共用的元数据
+CallSite unknown_site("unknown", 0, nullptr);
+}
+
+bool CallSite::register_and_check(LogLevel level) {
+    CallSiteRegistry::instance().register_site(*this);
+    return threshold_.load(std::memory_order_acquire) <= static_cast<uint8_t>(level) + 1;
+}
+
+CallSiteRegistry& CallSiteRegistry::instance() {
+    static CallSiteRegistry registry;
+    return registry;
+}
+
+CallSiteRegistry::CallSiteRegistry() {
+    sites_[0] = &unknown_site;
+}
+
+void CallSiteRegistry::register_site(CallSite& site) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 多个线程可能同时首次执行同一个调用点
+    if (site.threshold_.load(std::memory_order_relaxed) != CallSite::UNREGISTERED) {
+        return;
+    }
+    const uint32_t id = count_.load(std::memory_order_relaxed);
+    if (id < MAX_CALL_SITES) [[likely]] {
+        site.id_ = id;
+        sites_[id] = &site;
+        count_.store(id + 1, std::memory_order_release);
+    } else {
+        site.id_ = 0;
+        overflow_sites_.push_back(&site);
+    }
+    site.threshold_.store(resolve_threshold(site), std::memory_order_release);
+}
+
+uint8_t CallSiteRegistry::resolve_threshold(const CallSite& site) const {
+    LogLevel level = default_level_;
+    bool matched = false;
+    for (const auto& [file, file_level] : file_levels_) {
+        if (std::strcmp(site.file(), file.c_str()) == 0) {
+            level = file_level;
+            matched = true;
+        }
+    }
+    if (!matched && site.module() != nullptr) {
+        for (const auto& [module, module_level] : module_levels_) {
+            if (std::strcmp(site.module(), module.c_str()) == 0) {
+                level = module_level;
+            }
+        }
+    }
+    return static_cast<uint8_t>(level) + 1;
+}
+
+void CallSiteRegistry::refresh_thresholds() {
+    const uint32_t count = count_.load(std::memory_order_relaxed);
+    for (uint32_t id = 1; id < count; ++id) {
+        sites_[id]->threshold_.store(resolve_threshold(*sites_[id]), std::memory_order_release);
+    }
+    for (CallSite* site : overflow_sites_) {
+        site->threshold_.store(resolve_threshold(*site), std::memory_order_release);
+    }
+}
+
+void CallSiteRegistry::set_default_level(LogLevel level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    default_level_ = level;
+    refresh_thresholds();
+}
+
+namespace {
+// 同一个文件或模块只保留一项，反复切换级别不会让列表增长
+void set_override(std::vector<std::pair<std::string, LogLevel>>& overrides, const std::string& key, LogLevel level) {
+    for (auto& [name, current] : overrides) {
+        if (name == key) {
+            current = level;
+            return;
+        }
+    }
+    overrides.emplace_back(key, level);
+}
+}
+
+void CallSiteRegistry::set_file_level(const std::string& file, LogLevel level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    set_override(file_levels_, file, level);
+    refresh_thresholds();
+}
+
+void CallSiteRegistry::set_module_level(const std::string& module, LogLevel level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    set_override(module_levels_, module, level);
+    refresh_thresholds();
+}
+
+void CallSiteRegistry::clear_overrides() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_levels_.clear();
+    module_levels_.clear();
+    refresh_thresholds();
+}
+
+LogLevel CallSiteRegistry::default_level() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return default_level_;
+}
+
+}
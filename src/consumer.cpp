@@ -1,55 +1,50 @@
 #include "../include/consumer.h"
+#include "../include/time_cache.h"
 #include <cstdint>
 #include <iostream>
 #include <chrono>
 #include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <ctime>
 #include <cstring>
+#include <algorithm>
+#include <cmath>
 
 namespace logF {
-struct TimeCache {
-    int64_t cached_milliseconds = 0;
-    char cached_time_str[32] = {0};  // MM-DD HH:MM:SS.sss 格式预留足够空间
-    
-    // 只在毫秒变化时重新格式化时间字符串
-    void update_time_string(const std::chrono::system_clock::time_point& timestamp) {
-        // 获取毫秒级时间戳
-        auto ms_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(
-            timestamp.time_since_epoch()).count();
-        
-        if (ms_since_epoch == cached_milliseconds) return;
-        
-        auto seconds_since_epoch = ms_since_epoch / 1000;
-        int milliseconds = static_cast<int>(ms_since_epoch - seconds_since_epoch * 1000);
-        
-        std::time_t seconds = static_cast<std::time_t>(seconds_since_epoch);
-        
-        // 获取本地时间
-        std::tm* local_tm = std::localtime(&seconds);
-        
-        // 使用strftime格式化基本时间部分
-        char base_time[16];
-        std::strftime(base_time, sizeof(base_time), "%H:%M:%S", local_tm);
-        
-        // 添加毫秒部分
-        std::snprintf(cached_time_str, sizeof(cached_time_str),
-                     "%s.%03d", base_time, milliseconds);
-        
-        cached_milliseconds = ms_since_epoch;
-    }
-};
 TimeCache time_cache;
 
 Consumer::Consumer(MpscRingBuffer<LogMessage>& ring_buffer, const std::string& log_dir, size_t mmap_file_size)
     : ring_buffer_(ring_buffer), mmap_writer_(log_dir, mmap_file_size), 
-      char_buffer_(65536*2) {}
+      char_buffer_(65536*2), call_sites_(CallSiteRegistry::instance()),
+      recorder_(FlightRecorder::instance()), profiler_(call_sites_),
+      flush_threshold_(char_buffer_.capacity() - 256) {}
+
+bool Consumer::enable_compression(size_t block_size) {
+    if (block_size == 0 || block_size + 256 > char_buffer_.capacity()) {
+        return false;
+    }
+    compress_ = true;
+    flush_threshold_ = block_size;
+    block_buffer_.resize(sizeof(BlockHeader) + lz::compress_bound(char_buffer_.capacity()));
+    mmap_writer_.set_file_extension(".logz");
+    return true;
+}
 
 void Consumer::start() {
     running_.store(true, std::memory_order_release);
+    if (config_store_ != nullptr) {
+        apply_config();
+    }
+    // 上次崩溃留下的段先截断到最后一条完整记录，再开始写新段
+    if (startup_recovery_) {
+        recover_segments(mmap_writer_.log_dir());
+    }
     if (!mmap_writer_.open()) [[unlikely]] {
         std::cerr << "Failed to open mmap writer" << std::endl;
         return;
     }
+    ring_buffer_.set_consumer_running(true);
     thread_ = std::thread(&Consumer::run, this);
     cpu_set_t cpuset;
     CPU_ZERO(&cpuset);
@@ -64,6 +59,22 @@ void Consumer::start() {
     }
 }
 
+Consumer::~Consumer() {
+    stop();
+    // 停止后才进入缓冲区的控制消息没有消费者处理，在这里释放其负载
+    while (true) {
+        auto buffer_view = ring_buffer_.read();
+        if (buffer_view.empty()) {
+            break;
+        }
+        for (const LogMessage& msg : buffer_view) {
+            if (msg.is_control()) {
+                discard_control(msg);
+            }
+        }
+    }
+}
+
 void Consumer::stop() {
     running_.store(false, std::memory_order_release);
     if (thread_.joinable()) {
@@ -73,8 +84,16 @@ void Consumer::stop() {
 }
 
 void Consumer::run() {
+    thread_id_.store(static_cast<pid_t>(syscall(SYS_gettid)), std::memory_order_release);
     uint64_t local_count = 0;
     while (running_.load(std::memory_order_acquire)) {
+        if (FlightRecorder::take_dump_request()) [[unlikely]] {
+            dump_flight_recorder(std::chrono::system_clock::now(), false);
+        }
+        // 批次边界：只读一次版本号
+        if (config_store_ != nullptr && config_store_->version() != config_version_) [[unlikely]] {
+            apply_config();
+        }
         auto buffer_view = ring_buffer_.read();
         if (buffer_view.size() == 0) {
             if (local_count < 50) {
@@ -82,92 +101,690 @@ void Consumer::run() {
                 continue;
             }
             local_count = 0;
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            // 空闲时，超过时间窗口的重复计数不再等待下一条不同的消息
+            if (repeat_count_ > 0 &&
+                std::chrono::system_clock::now() - last_msg_.timestamp > coalesce_window_) {
+                flush_repeats();
+            }
+            // 附加 sink 在空闲时就写出，不等格式化缓冲区写满
+            flush_sinks();
+            // 空闲时也按周期写出调用点统计
+            if (profiler_.enabled()) [[unlikely]] {
+                profiler_.maybe_report(std::chrono::steady_clock::now());
+            }
+            if (wait_strategy_ == WaitStrategy::SLEEP) {
+                std::this_thread::sleep_for(idle_sleep_);
+            } else if (wait_strategy_ == WaitStrategy::YIELD) {
+                std::this_thread::yield();
+            }
             continue;
         }
-        for (const auto& msg : buffer_view) {
+        process_batch(buffer_view);
+    }
+    // 停止前不再接受新的屏障，等正在入队的 flush 完成后处理完环形缓冲区中已发布的消息，
+    // 未完成的 flush 句柄都会就绪
+    ring_buffer_.set_consumer_running(false);
+    while (true) {
+        const bool senders_idle = ring_buffer_.control_senders_idle();
+        auto buffer_view = ring_buffer_.read();
+        if (buffer_view.empty()) {
+            if (senders_idle) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        process_batch(buffer_view);
+    }
+    // Flush any remaining data when stopping
+    flush_repeats();
+    flush_buffer();
+    tracer_.publish();
+    if (profiler_.enabled()) {
+        profiler_.report();
+    }
+}
+
+void Consumer::apply_config() {
+    config_version_ = config_store_->version();
+    const auto config = config_store_->snapshot();
+    if (config->output_format != output_format_) {
+        flush_repeats();  // 已合并的计数按旧格式输出
+        output_format_ = config->output_format;
+    }
+    wait_strategy_ = config->wait_strategy;
+    idle_sleep_ = config->idle_sleep;
+    if (config->segment_size != 0) {
+        mmap_writer_.set_file_size(config->segment_size);
+    }
+    if (!config->log_dir.empty() && config->log_dir != mmap_writer_.log_dir()) {
+        // 已格式化的内容写入旧目录后再切换
+        flush_repeats();
+        flush_buffer();
+        if (!mmap_writer_.set_log_dir(config->log_dir)) [[unlikely]] {
+            std::cerr << "Failed to switch log directory to " << config->log_dir << std::endl;
+        }
+    }
+}
+
+// 合并重复、调用点统计这类逐条生效的模式在批次开始时判断一次（输出格式只在批次之间切换），
+// 常规路径是一个紧凑的循环，并提前预取后面的槽位
+void Consumer::process_batch(const MpscRingBuffer<LogMessage>::ReadView& view) {
+    if (coalesce_window_.count() > 0 || profiler_.enabled()) [[unlikely]] {
+        for (const auto& msg : view) {
+            process(msg);
+        }
+        return;
+    }
+    constexpr size_t PREFETCH_DISTANCE = 4;
+    const bool tracing = tracer_.enabled();
+    const auto end = view.end();
+    auto ahead = view.begin();
+    for (size_t i = 0; i < PREFETCH_DISTANCE && ahead != end; ++i, ++ahead) {
+        __builtin_prefetch(&*ahead);
+    }
+    for (auto it = view.begin(); it != end; ++it) {
+        if (ahead != end) {
+            __builtin_prefetch(&*ahead);
+            ++ahead;
+        }
+        const LogMessage& msg = *it;
+        if (msg.is_control()) [[unlikely]] {
+            handle_control(msg);
+            continue;
+        }
+        if (msg.level >= static_cast<uint8_t>(LogLevel::ERROR) && FlightRecorder::active()) [[unlikely]] {
+            dump_flight_recorder(msg.timestamp, true);
+        }
+        if (tracing && tracer_.should_sample()) [[unlikely]] {
+            const int64_t dequeued_ns = LatencyTracer::now_ns();
             format_log(msg);
+            tracer_.record_formatted(LatencyTracer::to_ns(msg.timestamp), dequeued_ns, LatencyTracer::now_ns());
+        } else {
+            format_log(msg);
+        }
+        message_count_++;
+    }
+}
+
+void Consumer::process(const LogMessage& msg) {
+    if (msg.is_control()) [[unlikely]] {
+        handle_control(msg);
+        return;
+    }
+    if (coalesce_window_.count() > 0) [[unlikely]] {
+        if (coalesce(msg)) {
             message_count_++;
+            return;
         }
     }
-    // Flush any remaining data when stopping
-    char_buffer_.flush_to_mmap(mmap_writer_);
+    if (msg.level >= static_cast<uint8_t>(LogLevel::ERROR) && FlightRecorder::active()) [[unlikely]] {
+        dump_flight_recorder(msg.timestamp, true);
+    }
+    // 延迟采样与调用点统计可以同时开启
+    const bool sampled = tracer_.enabled() && tracer_.should_sample();
+    const int64_t dequeued_ns = sampled ? LatencyTracer::now_ns() : 0;
+    if (profiler_.enabled()) [[unlikely]] {
+        profile_format(msg);
+    } else {
+        format_log(msg);
+    }
+    if (sampled) [[unlikely]] {
+        tracer_.record_formatted(LatencyTracer::to_ns(msg.timestamp), dequeued_ns, LatencyTracer::now_ns());
+    }
+    message_count_++;
+}
+
+void Consumer::profile_format(const LogMessage& msg) {
+    const size_t before = char_buffer_.size();
+    const auto start = std::chrono::steady_clock::now();
+    format_log(msg);
+    const auto end = std::chrono::steady_clock::now();
+    const size_t after = char_buffer_.size();
+    // format_log 在追加之前可能已经把缓冲区写出
+    const size_t bytes = after >= before ? after - before : after;
+    profiler_.record(msg.site_id, msg.format, bytes,
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    profiler_.maybe_report(end);
+}
+
+void Consumer::flush_buffer() {
+    if (compress_) [[unlikely]] {
+        write_compressed_block();
+    } else {
+        char_buffer_.flush_to_mmap(mmap_writer_, index_marks_.data(), index_marks_.size());
+    }
     char_buffer_.clear();
+    index_marks_.clear();
+    flush_sinks();
+    if (tracer_.enabled()) [[unlikely]] {
+        tracer_.record_written();
+    }
+}
+
+void Consumer::enable_index(size_t interval) {
+    index_interval_ = interval == 0 ? 1 : interval;
+    mmap_writer_.enable_index(true);
+}
+
+void Consumer::mark_index(const LogMessage& msg) {
+    const size_t pos = char_buffer_.size();
+    if (index_marks_.empty() || pos >= next_mark_at_) {
+        IndexEntry mark{};
+        mark.offset = pos;
+        mark.first_timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            msg.timestamp.time_since_epoch()).count();
+        index_marks_.push_back(mark);
+        next_mark_at_ = pos + index_interval_;
+    }
+    if (msg.level < LOG_LEVEL_COUNT) [[likely]] {
+        ++index_marks_.back().level_counts[msg.level];
+    }
+}
+
+void Consumer::write_compressed_block() {
+    if (char_buffer_.size() == 0) {
+        return;
+    }
+    const int64_t first_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        block_first_ts_.time_since_epoch()).count();
+    const size_t frame_len = encode_block(char_buffer_.data(), char_buffer_.size(), first_ns, block_buffer_.data());
+    if (index_marks_.empty()) {
+        mmap_writer_.write(block_buffer_.data(), frame_len);
+        return;
+    }
+    // 块只能整体解压，合并为一个指向帧头的条目
+    IndexEntry entry = index_marks_.front();
+    entry.offset = 0;
+    for (size_t i = 1; i < index_marks_.size(); ++i) {
+        entry.first_timestamp_ns = std::min(entry.first_timestamp_ns, index_marks_[i].first_timestamp_ns);
+        for (size_t level = 0; level < LOG_LEVEL_COUNT; ++level) {
+            entry.level_counts[level] += index_marks_[i].level_counts[level];
+        }
+    }
+    mmap_writer_.write(block_buffer_.data(), frame_len, &entry, 1);
 }
 
+void Consumer::handle_control(const LogMessage& msg) {
+    switch (msg.control_type()) {
+        case ControlType::FLUSH: {
+            auto* token = static_cast<std::shared_ptr<FlushState>*>(
+                const_cast<void*>(msg.args[1].as_pointer()));
+            flush_repeats();
+            flush_buffer();
+            if ((*token)->sync()) {
+                mmap_writer_.sync();
+            }
+            (*token)->complete();
+            delete token;
+            break;
+        }
+        case ControlType::CONTEXT: {
+            auto* record = static_cast<ContextRecord*>(const_cast<void*>(msg.args[1].as_pointer()));
+            register_context(*record);
+            delete record;
+            break;
+        }
+        case ControlType::SKIP:
+            break;
+    }
+}
+
+void Consumer::discard_control(const LogMessage& msg) {
+    switch (msg.control_type()) {
+        case ControlType::FLUSH: {
+            auto* token = static_cast<std::shared_ptr<FlushState>*>(
+                const_cast<void*>(msg.args[1].as_pointer()));
+            (*token)->fail();
+            delete token;
+            break;
+        }
+        case ControlType::CONTEXT:
+            delete static_cast<ContextRecord*>(const_cast<void*>(msg.args[1].as_pointer()));
+            break;
+        case ControlType::SKIP:
+            break;
+    }
+}
+
+namespace {
+
+// 注册上下文时使用，不在热路径上
+void append_json_string(std::string& out, const std::string& value) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (unsigned char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+}
+
+void Consumer::register_context(const ContextRecord& record) {
+    if (record.id >= contexts_.size()) {
+        contexts_.resize(record.id + 1);
+    }
+    RenderedContext& rendered = contexts_[record.id];
+    rendered.text.clear();
+    rendered.json.clear();
+    if (!record.thread_name.empty()) {
+        rendered.text = record.thread_name;
+        rendered.json = ",\"thread\":";
+        append_json_string(rendered.json, record.thread_name);
+    }
+    for (const auto& [key, value] : record.fields) {
+        if (!rendered.text.empty()) {
+            rendered.text += ' ';
+        }
+        rendered.text += key;
+        rendered.text += '=';
+        rendered.text += value;
+        rendered.json += ',';
+        append_json_string(rendered.json, key);
+        rendered.json += ':';
+        append_json_string(rendered.json, value);
+    }
+    if (!rendered.text.empty()) {
+        rendered.text = "[" + rendered.text + "] ";
+    }
+}
+
+bool Consumer::is_repeat(const LogMessage& msg) const {
+    if (msg.site_id != last_msg_.site_id || msg.format != last_msg_.format ||
+        msg.level != last_msg_.level || msg.num_args != last_msg_.num_args ||
+        msg.context_id != last_msg_.context_id) {
+        return false;
+    }
+    if (msg.timestamp - last_msg_.timestamp > coalesce_window_) {
+        return false;
+    }
+    for (size_t i = 0; i < msg.num_args; ++i) {
+        const auto& a = msg.args[i];
+        const auto& b = last_msg_.args[i];
+        if (a.get_type() != b.get_type()) return false;
+        if (a.get_type() == LogVariant::Type::CSTR) {
+            if (a.as_cstr() != b.as_cstr() &&
+                (a.as_cstr() == nullptr || b.as_cstr() == nullptr || strcmp(a.as_cstr(), b.as_cstr()) != 0)) {
+                return false;
+            }
+        } else if (std::memcmp(&a.data, &b.data, sizeof(a.data)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Consumer::coalesce(const LogMessage& msg) {
+    if (has_last_msg_ && is_repeat(msg)) {
+        ++repeat_count_;
+        repeat_suppressed_ += msg.suppressed;  // 限流抑制的条数并入摘要，不丢失
+        last_repeat_time_ = msg.timestamp;
+        return true;
+    }
+    flush_repeats();
+    last_msg_ = msg;
+    has_last_msg_ = true;
+    return false;
+}
+
+void Consumer::flush_repeats() {
+    if (repeat_count_ == 0) {
+        return;
+    }
+    if (char_buffer_.size() >= flush_threshold_) [[unlikely]] {
+        flush_buffer();
+    }
+    if (char_buffer_.size() == 0) {
+        block_first_ts_ = last_repeat_time_;
+    }
+    const size_t record_start = char_buffer_.size();
+    if (output_format_ == OutputFormat::JSON) [[unlikely]] {
+        append_json_prefix(last_repeat_time_, last_msg_.level, call_sites_.site(last_msg_.site_id),
+                           last_msg_.context_id);
+        char_buffer_.append(",\"repeated\":");
+        char_buffer_.append_number(static_cast<long long>(repeat_count_));
+        if (repeat_suppressed_ > 0) [[unlikely]] {
+            char_buffer_.append(",\"suppressed\":");
+            char_buffer_.append_number(static_cast<long long>(repeat_suppressed_));
+        }
+        char_buffer_.append("}\n");
+    } else {
+        append_prefix(last_repeat_time_, last_msg_.level, site_format(last_msg_.site_id, last_msg_.format),
+                      last_msg_.context_id);
+        char_buffer_.append("repeated ");
+        char_buffer_.append_number(static_cast<long long>(repeat_count_));
+        char_buffer_.append(" times, last at ");
+        char_buffer_.append(time_cache.cached_time_str);
+        if (repeat_suppressed_ > 0) [[unlikely]] {
+            char_buffer_.append(" (suppressed ");
+            char_buffer_.append_number(static_cast<long long>(repeat_suppressed_));
+            char_buffer_.append(')');
+        }
+        char_buffer_.append('\n');
+    }
+    if (!sinks_.empty()) [[unlikely]] {
+        dispatch_to_sinks(last_msg_.level, record_start);
+    }
+    repeat_count_ = 0;
+    repeat_suppressed_ = 0;
+    // 计数输出后，后续相同的消息重新开始一轮
+    has_last_msg_ = false;
+}
+
+void Consumer::dump_flight_recorder(std::chrono::system_clock::time_point event_time, bool on_error) {
+    const auto window = recorder_.window();
+    if (on_error && event_time < last_dump_time_ + window) {
+        return;  // 上一次转储之后的记录留给下一次
+    }
+    // 已经转储过的记录不再重复输出
+    auto from = std::max(last_dump_time_, event_time - window);
+    recorder_records_.clear();
+    recorder_.collect(from, event_time, recorder_records_);
+    last_dump_time_ = std::max(last_dump_time_, event_time);
+    if (recorder_records_.empty()) {
+        return;
+    }
+    flush_repeats();
+    if (char_buffer_.size() >= flush_threshold_) [[unlikely]] {
+        flush_buffer();
+    }
+    if (char_buffer_.size() == 0) {
+        block_first_ts_ = from;
+    }
+    const bool json = output_format_ == OutputFormat::JSON;
+    char_buffer_.append(json ? "{\"flight_recorder\":" : "---- flight recorder: ");
+    char_buffer_.append_number(static_cast<long long>(recorder_records_.size()));
+    char_buffer_.append(json ? "}\n" : " records ----\n");
+    for (const auto& record : recorder_records_) {
+        format_log(record);
+    }
+    char_buffer_.append(json ? "{\"flight_recorder_end\":true}\n" : "---- flight recorder end ----\n");
+}
+
+namespace {
+
+struct LevelTag {
+    const char* text;
+    size_t len;
+};
+
+constexpr LevelTag LEVEL_TAGS[LOG_LEVEL_COUNT] = {
+    {" [TRACE] ", 9}, {" [DEBUG] ", 9}, {" [INFO] ", 8}, {"[WARNING] ", 10}, {" [ERROR] ", 9},
+};
+
+}
+
+void Consumer::append_prefix(std::chrono::system_clock::time_point timestamp, uint8_t level, const SiteFormat& site,
+                             uint16_t context_id) {
+    time_cache.update_time_string(timestamp);
+    char_buffer_.append(time_cache.cached_time_str, time_cache.cached_len);
+    if (level < LOG_LEVEL_COUNT) [[likely]] {
+        char_buffer_.append(LEVEL_TAGS[level].text, LEVEL_TAGS[level].len);
+    }
+    if (context_id != 0 && context_id < contexts_.size()) [[unlikely]] {
+        const std::string& text = contexts_[context_id].text;
+        char_buffer_.append(text.data(), text.size());
+    }
+    char_buffer_.append(site.location.data(), site.location.size());
+}
+
+// 调用点的格式串是字面量，同一个 id 总是同一个指针；不同时（不应发生）重新切分
+const Consumer::SiteFormat& Consumer::site_format(uint32_t site_id, const char* format) {
+    if (site_id >= site_formats_.size()) [[unlikely]] {
+        site_formats_.resize(site_id + 1);
+    }
+    SiteFormat& entry = site_formats_[site_id];
+    if (entry.format == format) [[likely]] {
+        return entry;
+    }
+    const CallSite* site = call_sites_.site(site_id);
+    entry.location = site->file();
+    entry.location += ':';
+    entry.location += std::to_string(site->line());
+    entry.location += ' ';
+    entry.format = format;
+    // 与逐字符解析一致：最多 MAX_LOG_ARGS 个占位符，之后的 % 原样输出
+    entry.pieces = 0;
+    const char* p = format;
+    while (true) {
+        const char* percent = entry.pieces < MAX_LOG_ARGS ? std::strchr(p, '%') : nullptr;
+        entry.piece_begin[entry.pieces] = static_cast<uint32_t>(p - format);
+        if (percent == nullptr) {
+            entry.piece_len[entry.pieces++] = static_cast<uint32_t>(std::strlen(p));
+            break;
+        }
+        entry.piece_len[entry.pieces++] = static_cast<uint32_t>(percent - p);
+        p = percent + 1;
+    }
+    return entry;
+}
 
 void Consumer::format_log(const LogMessage& msg) {
+    const CallSite* site = call_sites_.site(msg.site_id);
     // Check if we need to flush the buffer (leave some space for current message)
-    if (!char_buffer_.has_space(256)) [[unlikely]] {
-        char_buffer_.flush_to_mmap(mmap_writer_);
-        char_buffer_.clear();
-    }
-    time_cache.update_time_string(msg.timestamp);
-    
-    // Append all components directly to char buffer
-    char_buffer_.append(time_cache.cached_time_str);
-    switch (static_cast<LogLevel>(msg.level)) {
-        case LogLevel::INFO:
-            char_buffer_.append(" [INFO] ");
-            break;
-        case LogLevel::WARNING:
-            char_buffer_.append("[WARNING] ");
-            break;
-        case LogLevel::ERROR:
-            char_buffer_.append(" [ERROR] ");
-            break;
-    }
-    if (msg.file) [[likely]] {
-        char_buffer_.append(msg.file);
-    } else [[unlikely]] {
-        char_buffer_.append("unknown");
-    }
-    char_buffer_.append(":");
-    char_buffer_.append_number(static_cast<long long>(msg.line));
-    char_buffer_.append(" ");
-    
-    // Process format string and arguments
-    const char* p = msg.format;
-    size_t arg_index = 0;
-
-    while (*p != '\0' && arg_index < msg.args.size()) {
-        const char* percent_pos = strchr(p, '%');
-        
-        if (percent_pos == nullptr) {
-            // No more placeholders, append remaining text
-            char_buffer_.append(p);
-            break;
+    if (char_buffer_.size() >= flush_threshold_ ||
+        (site->has_blob() && char_buffer_.size() + BLOB_RESERVE >= char_buffer_.capacity())) [[unlikely]] {
+        flush_buffer();
+    }
+    if (char_buffer_.size() == 0) {
+        block_first_ts_ = msg.timestamp;
+    }
+    if (index_interval_ != 0) [[unlikely]] {
+        mark_index(msg);
+    }
+    const size_t record_start = char_buffer_.size();
+    if (output_format_ == OutputFormat::JSON) [[unlikely]] {
+        format_json(msg, site);
+    } else {
+        const SiteFormat& format = site_format(msg.site_id, msg.format);
+        append_prefix(msg.timestamp, msg.level, format, msg.context_id);
+        if (site->key_count() > 0) [[unlikely]] {
+            append_kv_text(msg, site);
+        } else {
+            append_body<false>(msg, format);
         }
-        
-        // Append text before the placeholder
-        if (percent_pos > p) {
-            char_buffer_.append(p, percent_pos - p);
+
+        if (msg.suppressed > 0) [[unlikely]] {
+            char_buffer_.append(" (suppressed ");
+            char_buffer_.append_number(static_cast<long long>(msg.suppressed));
+            char_buffer_.append(')');
         }
         
-        // Append the argument value
-        const auto& arg = msg.args[arg_index];
-        switch (arg.get_type()) {
-            case LogVariant::Type::CSTR:
-                char_buffer_.append(arg.as_cstr());
-                break;
-            case LogVariant::Type::DOUBLE:
-                char_buffer_.append_number(arg.as_double());
-                break;
-            case LogVariant::Type::INT:
-                char_buffer_.append_number(static_cast<long long>(arg.as_int()));
+        char_buffer_.append('\n');
+    }
+    if (!sinks_.empty()) [[unlikely]] {
+        dispatch_to_sinks(msg.level, record_start);
+    }
+}
+
+void Consumer::dispatch_to_sinks(uint8_t level, size_t record_start) {
+    const char* data = char_buffer_.data() + record_start;
+    const size_t len = char_buffer_.size() - record_start;
+    for (auto& sink : sinks_) {
+        if (sink->accepts(level)) {
+            sink->write(data, len);
+        }
+    }
+}
+
+void Consumer::flush_sinks() {
+    for (auto& sink : sinks_) {
+        sink->flush();
+    }
+}
+
+template<bool Escape>
+void Consumer::append_body(const LogMessage& msg, const SiteFormat& format) {
+    // 字面段之间依次插入参数
+    append_text<Escape>(msg.format + format.piece_begin[0], format.piece_len[0]);
+    for (uint8_t i = 1; i < format.pieces; ++i) {
+        append_arg<Escape>(msg.args[i - 1]);
+        append_text<Escape>(msg.format + format.piece_begin[i], format.piece_len[i]);
+    }
+}
+
+// 空指针字符串在文本中输出为 (null)，作为 JSON 值时输出为 null
+template<bool Escape>
+void Consumer::append_arg(const LogVariant& arg) {
+    switch (arg.get_type()) {
+        case LogVariant::Type::CSTR:
+            if (arg.as_cstr() == nullptr) [[unlikely]] {
+                append_text<Escape>("(null)", 6);
+            } else {
+                append_text<Escape>(arg.as_cstr(), strlen(arg.as_cstr()));
+            }
+            break;
+        case LogVariant::Type::DOUBLE:
+            char_buffer_.append_number(arg.as_double());
+            break;
+        case LogVariant::Type::INT:
+            char_buffer_.append_number(static_cast<long long>(arg.as_int()));
+            break;
+        case LogVariant::Type::POINTER:
+            char_buffer_.append_number(static_cast<long long>(reinterpret_cast<uintptr_t>(arg.as_pointer())));
+            break;
+        case LogVariant::Type::BLOB:
+            append_blob(arg.as_blob());
+            break;
+    }
+}
+
+template<bool Escape>
+void Consumer::append_text(const char* data, size_t len) {
+    if constexpr (Escape) {
+        char_buffer_.append_json_escaped(data, len);
+    } else {
+        char_buffer_.append(data, len);
+    }
+}
+
+// event key=value ...，含空格、引号或等号的字符串值加引号并转义
+void Consumer::append_kv_text(const LogMessage& msg, const CallSite* site) {
+    char_buffer_.append(msg.format);
+    const size_t count = std::min<size_t>(site->key_count(), msg.num_args);
+    for (size_t i = 0; i < count; ++i) {
+        char_buffer_.append(' ');
+        char_buffer_.append(site->keys()[i]);
+        char_buffer_.append('=');
+        const auto& arg = msg.args[i];
+        if (arg.get_type() == LogVariant::Type::CSTR) {
+            const char* value = arg.as_cstr();
+            if (value == nullptr) [[unlikely]] {
+                char_buffer_.append("(null)");
+            } else if (value[0] == '\0' || strpbrk(value, " \"=") != nullptr) {
+                char_buffer_.append('"');
+                char_buffer_.append_json_escaped(value);
+                char_buffer_.append('"');
+            } else {
+                char_buffer_.append(value);
+            }
+        } else {
+            append_json_value(arg);
+        }
+    }
+}
+
+// 结构化的值供程序读取：浮点数输出最短往返表示，整数保留 64 位
+void Consumer::append_json_value(const LogVariant& arg) {
+    switch (arg.get_type()) {
+        case LogVariant::Type::CSTR:
+            if (arg.as_cstr() == nullptr) [[unlikely]] {
+                char_buffer_.append("null");
                 break;
+            }
+            char_buffer_.append('"');
+            char_buffer_.append_json_escaped(arg.as_cstr());
+            char_buffer_.append('"');
+            break;
+        case LogVariant::Type::DOUBLE:
+            if (std::isfinite(arg.as_double())) [[likely]] {
+                char_buffer_.append_number_exact(arg.as_double());
+            } else {
+                char_buffer_.append("null");
+            }
+            break;
+        case LogVariant::Type::INT:
+            char_buffer_.append_number(static_cast<long long>(arg.as_int()));
+            break;
+        case LogVariant::Type::POINTER:
+            char_buffer_.append_number(static_cast<long long>(reinterpret_cast<uintptr_t>(arg.as_pointer())));
+            break;
+        case LogVariant::Type::BLOB:
+            char_buffer_.append('"');
+            append_blob(arg.as_blob());
+            char_buffer_.append('"');
+            break;
+    }
+}
+
+// 十六进制输出后立即回收负载所在的区域
+void Consumer::append_blob(const BlobHeader* blob) {
+    if (blob == nullptr) [[unlikely]] {
+        char_buffer_.append("<blob dropped>");
+        return;
+    }
+    char_buffer_.append_hex(blob->data(), blob->len);
+    if (blob->original_len > blob->len) {
+        char_buffer_.append("... (");
+        char_buffer_.append_number(static_cast<long long>(blob->original_len));
+        char_buffer_.append(" bytes)");
+    }
+    blob->arena->release(blob);
+}
+
+// {"ts":<Unix 毫秒>,"level":"INFO","site":"file:line", ...
+void Consumer::append_json_prefix(std::chrono::system_clock::time_point timestamp, uint8_t level, const CallSite* site,
+                                  uint16_t context_id) {
+    static const char* const level_names[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR"};
+    char_buffer_.append("{\"ts\":");
+    char_buffer_.append_number(static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count()));
+    char_buffer_.append(",\"level\":\"");
+    char_buffer_.append(level < LOG_LEVEL_COUNT ? level_names[level] : "UNKNOWN");
+    char_buffer_.append("\",\"site\":\"");
+    char_buffer_.append_json_escaped(site->file());
+    char_buffer_.append(':');
+    char_buffer_.append_number(static_cast<long long>(site->line()));
+    char_buffer_.append('"');
+    if (context_id != 0 && context_id < contexts_.size()) [[unlikely]] {
+        const std::string& json = contexts_[context_id].json;
+        char_buffer_.append(json.data(), json.size());
+    }
+}
+
+void Consumer::format_json(const LogMessage& msg, const CallSite* site) {
+    append_json_prefix(msg.timestamp, msg.level, site, msg.context_id);
+    if (site->key_count() > 0) {
+        char_buffer_.append(",\"event\":\"");
+        char_buffer_.append_json_escaped(msg.format);
+        char_buffer_.append('"');
+        const size_t count = std::min<size_t>(site->key_count(), msg.num_args);
+        for (size_t i = 0; i < count; ++i) {
+            char_buffer_.append(",\"");
+            char_buffer_.append_json_escaped(site->keys()[i]);
+            char_buffer_.append("\":");
+            append_json_value(msg.args[i]);
         }
-        
-        arg_index++;
-        p = percent_pos + 1;  // Move past the '%'
+    } else {
+        char_buffer_.append(",\"msg\":\"");
+        append_body<true>(msg, site_format(msg.site_id, msg.format));
+        char_buffer_.append('"');
     }
-    
-    // Append any remaining text after all placeholders are processed
-    if (*p != '\0' && arg_index >= msg.args.size()) {
-        char_buffer_.append(p);
+    if (msg.suppressed > 0) [[unlikely]] {
+        char_buffer_.append(",\"suppressed\":");
+        char_buffer_.append_number(static_cast<long long>(msg.suppressed));
     }
-    
-    char_buffer_.append('\n');
+    char_buffer_.append("}\n");
 }
 
 }
\ No newline at end of file
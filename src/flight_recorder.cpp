@@ -0,0 +1,115 @@
+#include "../include/flight_recorder.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace logF {
+
+std::atomic<bool> FlightRecorder::active_{true};
+std::atomic<bool> FlightRecorder::dump_requested_{false};
+
+RecorderBuffer::RecorderBuffer(size_t capacity)
+    : slots_(std::make_unique<Slot[]>(capacity)), mask_(capacity - 1) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("Capacity must be a power of 2.");
+    }
+}
+
+void RecorderBuffer::collect(std::chrono::system_clock::time_point from,
+                             std::chrono::system_clock::time_point to,
+                             std::vector<LogMessage>& out) const {
+    // 最新记录都不在窗口内时不必逐槽扫描
+    if (newest_ns_.load(std::memory_order_relaxed) <= from.time_since_epoch().count()) {
+        return;
+    }
+    const size_t capacity = mask_ + 1;
+    for (size_t i = 0; i < capacity; ++i) {
+        const Slot& slot = slots_[i];
+        const uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1) != 0) {
+            continue;
+        }
+        LogMessage copy = slot.msg;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before) {
+            continue;  // 读取期间被覆盖
+        }
+        if (copy.timestamp > from && copy.timestamp <= to) {
+            out.push_back(copy);
+        }
+    }
+}
+
+FlightRecorder& FlightRecorder::instance() {
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+void FlightRecorder::configure(size_t per_thread_capacity, std::chrono::milliseconds window) {
+    if (per_thread_capacity == 0 || (per_thread_capacity & (per_thread_capacity - 1)) != 0) {
+        throw std::invalid_argument("Capacity must be a power of 2.");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    per_thread_capacity_ = per_thread_capacity;
+    window_ms_.store(window.count(), std::memory_order_relaxed);
+}
+
+namespace {
+// 线程退出时归还缓冲区，新线程可以复用
+struct LocalBufferHandle {
+    RecorderBuffer* buffer = nullptr;
+    ~LocalBufferHandle() {
+        if (buffer) buffer->release();
+    }
+};
+}
+
+RecorderBuffer& FlightRecorder::local_buffer() {
+    thread_local LocalBufferHandle handle;
+    if (handle.buffer == nullptr) [[unlikely]] {
+        handle.buffer = instance().acquire_buffer();
+    }
+    return *handle.buffer;
+}
+
+RecorderBuffer* FlightRecorder::acquire_buffer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& buffer : buffers_) {
+        if (buffer->mask_ + 1 == per_thread_capacity_ &&
+            !buffer->in_use_.exchange(true, std::memory_order_acquire)) {
+            return buffer.get();
+        }
+    }
+    buffers_.push_back(std::make_unique<RecorderBuffer>(per_thread_capacity_));
+    buffers_.back()->in_use_.store(true, std::memory_order_relaxed);
+    return buffers_.back().get();
+}
+
+void FlightRecorder::collect(std::chrono::system_clock::time_point from,
+                             std::chrono::system_clock::time_point to,
+                             std::vector<LogMessage>& out) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& buffer : buffers_) {
+            buffer->collect(from, to, out);
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const LogMessage& a, const LogMessage& b) {
+        return a.timestamp < b.timestamp;
+    });
+}
+
+namespace {
+void dump_signal_handler(int) {
+    FlightRecorder::trigger_dump();
+}
+}
+
+bool FlightRecorder::install_signal_handler(int signo) {
+    struct sigaction action {};
+    action.sa_handler = dump_signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    return sigaction(signo, &action, nullptr) == 0;
+}
+
+}
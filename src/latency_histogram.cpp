@@ -0,0 +1,61 @@
+#include "../include/latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace logF {
+
+void LatencyHistogram::record_corrected(uint64_t value, uint64_t expected_interval) {
+    record(value);
+    if (expected_interval == 0 || value <= expected_interval) {
+        return;
+    }
+    for (uint64_t missing = value - expected_interval; missing >= expected_interval; missing -= expected_interval) {
+        record(missing);
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::reset() {
+    counts_.fill(0);
+    total_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+}
+
+uint64_t LatencyHistogram::upper_bound_of(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const size_t offset = index - SUB_BUCKET_COUNT;
+    const uint64_t shift = offset / SUB_BUCKET_HALF + 1;
+    const uint64_t mantissa = offset % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    if (total_ == 0) {
+        return 0;
+    }
+    const double clamped = std::min(100.0, std::max(0.0, percentile));
+    const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * total_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(upper_bound_of(i), max_);
+        }
+    }
+    return max_;
+}
+
+}
@@ -0,0 +1,40 @@
+#include "../include/latency_tracer.h"
+
+namespace logF {
+
+namespace {
+constexpr int64_t PUBLISH_INTERVAL_NS = 100 * 1000 * 1000;
+}
+
+void LatencyTracer::record_formatted(int64_t enqueued_ns, int64_t dequeued_ns, int64_t formatted_ns) {
+    live_.queueing.record(clamp(dequeued_ns - enqueued_ns));
+    live_.formatting.record(clamp(formatted_ns - dequeued_ns));
+    pending_formatted_ns_.push_back(formatted_ns);
+}
+
+void LatencyTracer::record_written() {
+    if (pending_formatted_ns_.empty()) {
+        return;
+    }
+    const int64_t written_ns = now_ns();
+    for (int64_t formatted_ns : pending_formatted_ns_) {
+        live_.io.record(clamp(written_ns - formatted_ns));
+    }
+    pending_formatted_ns_.clear();
+    if (written_ns - last_publish_ns_ >= PUBLISH_INTERVAL_NS) {
+        publish();
+        last_publish_ns_ = written_ns;
+    }
+}
+
+void LatencyTracer::publish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    published_ = live_;
+}
+
+LatencyTracer::Snapshot LatencyTracer::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return published_;
+}
+
+}
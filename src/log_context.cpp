@@ -0,0 +1,50 @@
+#include "../include/log_context.h"
+
+namespace logF {
+
+std::atomic<uint64_t> ThreadContext::generation_{0};
+
+void ThreadContext::set_thread_name(std::string name) {
+    State& s = state();
+    s.name = std::move(name);
+    // 外层保存的注册里是旧线程名，全部作废
+    s.current = Registration{};
+    for (auto& saved : s.saved) {
+        saved = Registration{};
+    }
+    s.active = !s.name.empty() || !s.fields.empty();
+}
+
+void ThreadContext::push(std::string key, std::string value) {
+    State& s = state();
+    s.saved.push_back(s.current);
+    s.fields.emplace_back(std::move(key), std::move(value));
+    s.current = Registration{};
+    s.active = true;
+}
+
+void ThreadContext::pop() {
+    State& s = state();
+    if (s.fields.empty()) [[unlikely]] {
+        return;
+    }
+    s.fields.pop_back();
+    s.current = s.saved.back();
+    s.saved.pop_back();
+    s.active = !s.name.empty() || !s.fields.empty();
+}
+
+uint16_t ThreadContext::register_context(State& s, MpscRingBuffer<LogMessage>& ring) {
+    const uint64_t generation = generation_.fetch_add(1, std::memory_order_relaxed);
+    const auto id = static_cast<uint16_t>(generation % ID_SPACE + 1);
+    auto* record = new ContextRecord{id, s.name, s.fields};
+    // 控制消息与本线程之后的消息同序；环形缓冲区满时这条日志不带上下文，下次再注册
+    if (!ring.emplace(ControlType::CONTEXT, static_cast<const void*>(record))) [[unlikely]] {
+        delete record;
+        return 0;
+    }
+    s.current = Registration{&ring, id, generation};
+    return id;
+}
+
+}
@@ -0,0 +1,230 @@
+#include "../include/lz_block.h"
+#include <cstring>
+
+namespace logF {
+
+namespace lz {
+
+namespace {
+
+constexpr int HASH_BITS = 14;
+constexpr size_t LAST_LITERALS = 5;     // 末尾保留的字面量，保证最后一个序列只有字面量
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int SKIP_TRIGGER = 6;         // 连续未命中时加大步长，快速跳过不可压缩数据
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t hash(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+// 从 a、b 开始的公共前缀长度，不超过 limit - a
+inline size_t common_length(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+    const uint8_t* start = a;
+    while (a + 8 <= limit) {
+        const uint64_t diff = read64(a) ^ read64(b);
+        if (diff != 0) {
+            return static_cast<size_t>(a - start) + (__builtin_ctzll(diff) >> 3);
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return static_cast<size_t>(a - start);
+}
+
+inline uint8_t* write_length(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+// 写出一个序列；match_len 为 0 表示最后一个序列
+inline uint8_t* emit(uint8_t* op, const uint8_t* oend, const uint8_t* literals, size_t literal_len,
+                     size_t offset, size_t match_len) {
+    const size_t worst = 1 + literal_len / 255 + 1 + literal_len + 2 + match_len / 255 + 1;
+    if (static_cast<size_t>(oend - op) < worst) [[unlikely]] {
+        return nullptr;
+    }
+    uint8_t* token = op++;
+    const size_t ml = match_len ? match_len - MIN_MATCH : 0;
+    *token = static_cast<uint8_t>(((literal_len < 15 ? literal_len : 15) << 4) | (ml < 15 ? ml : 15));
+    if (literal_len >= 15) {
+        op = write_length(op, literal_len - 15);
+    }
+    std::memcpy(op, literals, literal_len);
+    op += literal_len;
+    if (match_len == 0) {
+        return op;
+    }
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    if (ml >= 15) {
+        op = write_length(op, ml - 15);
+    }
+    return op;
+}
+
+}
+
+size_t compress(const char* src, size_t len, char* dst, size_t capacity) {
+    const uint8_t* const base = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* const end = base + len;
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+    const uint8_t* const oend = op + capacity;
+
+    if (len > LAST_LITERALS + MIN_MATCH) {
+        const uint8_t* const match_limit = end - LAST_LITERALS;
+        uint32_t table[1 << HASH_BITS] = {};
+        ++ip;
+        uint32_t misses = 0;
+        while (ip + MIN_MATCH <= match_limit) {
+            const uint32_t sequence = read32(ip);
+            const uint32_t h = hash(sequence);
+            const uint8_t* ref = base + table[h];
+            table[h] = static_cast<uint32_t>(ip - base);
+            if (ref >= ip || static_cast<size_t>(ip - ref) > MAX_OFFSET || read32(ref) != sequence) {
+                ip += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+            // 向前扩展匹配
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            const size_t match_len = MIN_MATCH + common_length(ip + MIN_MATCH, ref + MIN_MATCH, match_limit);
+            op = emit(op, oend, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - ref), match_len);
+            if (op == nullptr) [[unlikely]] {
+                return 0;
+            }
+            ip += match_len;
+            anchor = ip;
+            // 匹配内部的位置也放进哈希表，提高下一次命中率
+            if (ip - 2 > base) {
+                table[hash(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+            }
+        }
+    }
+
+    op = emit(op, oend, anchor, static_cast<size_t>(end - anchor), 0, 0);
+    if (op == nullptr) [[unlikely]] {
+        return 0;
+    }
+    return static_cast<size_t>(op - reinterpret_cast<uint8_t*>(dst));
+}
+
+bool decompress(const char* src, size_t len, char* dst, size_t out_len) {
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* const iend = ip + len;
+    uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+    uint8_t* const obase = op;
+    uint8_t* const oend = op + out_len;
+
+    auto read_length = [&](size_t& value) {
+        uint8_t b;
+        do {
+            if (ip >= iend) return false;
+            b = *ip++;
+            value += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+        size_t literal_len = token >> 4;
+        if (literal_len == 15 && !read_length(literal_len)) return false;
+        if (literal_len > static_cast<size_t>(iend - ip) || literal_len > static_cast<size_t>(oend - op)) return false;
+        if (literal_len <= 16 && iend - ip >= 16 && oend - op >= 16) [[likely]] {
+            std::memcpy(op, ip, 16);  // 定长复制，多写的部分随后被覆盖
+        } else {
+            std::memcpy(op, ip, literal_len);
+        }
+        ip += literal_len;
+        op += literal_len;
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) return false;
+        const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t match_len = token & 15;
+        if (match_len == 15 && !read_length(match_len)) return false;
+        match_len += MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(op - obase) || match_len > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        const uint8_t* ref = op - offset;
+        if (offset >= 8 && static_cast<size_t>(oend - op) >= match_len + 16) [[likely]] {
+            // 以 8 字节为单位复制，偏移不小于 8 时每次读取的都是已经写好的数据
+            uint8_t* const match_end = op + match_len;
+            do {
+                std::memcpy(op, ref, 8);
+                op += 8;
+                ref += 8;
+            } while (op < match_end);
+            op = match_end;
+        } else if (offset >= match_len) {
+            std::memcpy(op, ref, match_len);
+            op += match_len;
+        } else {
+            // 重叠复制（例如重复字符），必须逐字节
+            for (size_t i = 0; i < match_len; ++i) {
+                *op++ = ref[i];
+            }
+        }
+    }
+    return op == oend;
+}
+
+}
+
+size_t encode_block(const char* src, size_t len, int64_t first_timestamp_ns, char* dst) {
+    BlockHeader header;
+    header.magic = BLOCK_MAGIC;
+    header.flags = 0;
+    header.uncompressed_len = static_cast<uint32_t>(len);
+    header.first_timestamp_ns = first_timestamp_ns;
+
+    char* payload = dst + sizeof(BlockHeader);
+    size_t compressed = lz::compress(src, len, payload, lz::compress_bound(len));
+    if (compressed == 0 || compressed >= len) {
+        std::memcpy(payload, src, len);
+        compressed = len;
+        header.flags |= BLOCK_RAW;
+    }
+    header.compressed_len = static_cast<uint32_t>(compressed);
+    std::memcpy(dst, &header, sizeof(header));
+    return sizeof(BlockHeader) + compressed;
+}
+
+bool decode_block(const BlockHeader& header, const char* payload, char* dst) {
+    if (header.flags & BLOCK_RAW) {
+        if (header.compressed_len != header.uncompressed_len) return false;
+        std::memcpy(dst, payload, header.uncompressed_len);
+        return true;
+    }
+    return lz::decompress(payload, header.compressed_len, dst, header.uncompressed_len);
+}
+
+}
@@ -1,4 +1,5 @@
 #include "../include/mmap_writer.h"
+#include "../include/segment_header.h"
 #include <iostream>
 #include <cerrno>
 #include <cstring>
@@ -7,11 +8,13 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <dirent.h>
+#include <cstdlib>
 
 namespace logF {
 
 MMapFileWriter::MMapFileWriter(const std::string& log_dir, size_t file_size)
-    : log_dir_(log_dir), file_size_(file_size) {
+    : log_dir_(log_dir), file_size_(file_size), next_file_size_(file_size) {
     // Ensure the log directory exists
     mkdir(log_dir_.c_str(), 0755);
 }
@@ -27,9 +30,18 @@ MMapFileWriter::MMapFileWriter(MMapFileWriter&& other) noexcept
     , fd_(other.fd_)
     , mapped_memory_(other.mapped_memory_)
     , file_size_(other.file_size_)
-    , write_pos_(other.write_pos_) {
+    , next_file_size_(other.next_file_size_)
+    , write_pos_(other.write_pos_)
+    , rotate_interval_(other.rotate_interval_)
+    , next_rotation_(other.next_rotation_)
+    , extension_(std::move(other.extension_))
+    , index_enabled_(other.index_enabled_)
+    , index_fd_(other.index_fd_)
+    , retention_(std::move(other.retention_)) {
+    std::memcpy(current_period_, other.current_period_, sizeof(current_period_));
     
     other.fd_ = -1;
+    other.index_fd_ = -1;
     other.mapped_memory_ = nullptr;
     other.file_size_ = 0;
     other.write_pos_ = 0;
@@ -46,9 +58,18 @@ MMapFileWriter& MMapFileWriter::operator=(MMapFileWriter&& other) noexcept {
         fd_ = other.fd_;
         mapped_memory_ = other.mapped_memory_;
         file_size_ = other.file_size_;
+        next_file_size_ = other.next_file_size_;
         write_pos_ = other.write_pos_;
+        rotate_interval_ = other.rotate_interval_;
+        next_rotation_ = other.next_rotation_;
+        std::memcpy(current_period_, other.current_period_, sizeof(current_period_));
+        extension_ = std::move(other.extension_);
+        index_enabled_ = other.index_enabled_;
+        index_fd_ = other.index_fd_;
+        retention_ = std::move(other.retention_);
         
         other.fd_ = -1;
+        other.index_fd_ = -1;
         other.mapped_memory_ = nullptr;
         other.file_size_ = 0;
         other.write_pos_ = 0;
@@ -57,6 +78,50 @@ MMapFileWriter& MMapFileWriter::operator=(MMapFileWriter&& other) noexcept {
     return *this;
 }
 
+void MMapFileWriter::set_retention(const RetentionPolicy& policy) {
+    retention_ = std::make_unique<RetentionManager>(log_dir_, policy);
+}
+
+bool MMapFileWriter::set_log_dir(const std::string& log_dir) {
+    if (log_dir == log_dir_) {
+        return true;
+    }
+    const bool was_open = is_open();
+    close();
+    log_dir_ = log_dir;
+    mkdir(log_dir_.c_str(), 0755);
+    // 新目录中重新查找可用的编号
+    current_period_[0] = '\0';
+    if (retention_) {
+        const RetentionPolicy policy = retention_->policy();
+        retention_.reset();  // 等旧目录的后台任务完成
+        retention_ = std::make_unique<RetentionManager>(log_dir_, policy);
+    }
+    return was_open ? open() : true;
+}
+
+int MMapFileWriter::next_free_index(const char* period) const {
+    // 进程重启或同一周期内再次打开时，不覆盖已有的段（包括压缩后的 .log.*）
+    int next = 0;
+    const size_t period_len = std::strlen(period);
+    DIR* dir = opendir(log_dir_.c_str());
+    if (dir == nullptr) {
+        return next;
+    }
+    while (dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (std::strncmp(name, period, period_len) != 0 || name[period_len] != '_') continue;
+        char* end = nullptr;
+        const long index = std::strtol(name + period_len + 1, &end, 10);
+        if (end != name + period_len + 1 && std::strncmp(end, extension_.c_str(), extension_.size()) == 0 &&
+            index >= next) {
+            next = static_cast<int>(index) + 1;
+        }
+    }
+    closedir(dir);
+    return next;
+}
+
 void MMapFileWriter::generate_new_filepath() {
     auto now = std::chrono::system_clock::now();
     auto in_time_t = std::chrono::system_clock::to_time_t(now);
@@ -64,16 +129,37 @@ void MMapFileWriter::generate_new_filepath() {
 
     char filepath_buffer[256]; // 在栈上分配足够大的缓冲区
 
-    // 格式化日期部分
-    char date_buffer[11]; // YYYY-MM-DD\0
-    std::strftime(date_buffer, sizeof(date_buffer), "%Y-%m-%d", &local_tm);
+    // 格式化周期部分：YYYY-MM-DD 或 YYYY-MM-DD_HH
+    char period_buffer[sizeof(current_period_)];
+    std::strftime(period_buffer, sizeof(period_buffer),
+                  rotate_interval_ == RotateInterval::HOURLY ? "%Y-%m-%d_%H" : "%Y-%m-%d", &local_tm);
+    if (std::strcmp(period_buffer, current_period_) != 0) {
+        std::memcpy(current_period_, period_buffer, sizeof(current_period_));
+        file_index_ = next_free_index(current_period_);
+    }
+
+    // 下一个时间边界
+    if (rotate_interval_ != RotateInterval::NONE) {
+        std::tm boundary = local_tm;
+        boundary.tm_min = 0;
+        boundary.tm_sec = 0;
+        boundary.tm_isdst = -1;
+        if (rotate_interval_ == RotateInterval::HOURLY) {
+            boundary.tm_hour += 1;
+        } else {
+            boundary.tm_hour = 0;
+            boundary.tm_mday += 1;
+        }
+        next_rotation_ = std::chrono::system_clock::from_time_t(std::mktime(&boundary));
+    }
 
     // 使用 snprintf 高效、安全地拼接所有部分
     int len = std::snprintf(filepath_buffer, sizeof(filepath_buffer),
-                            "%s/%s_%d.log",
+                            "%s/%s_%d%s",
                             log_dir_.c_str(),
-                            date_buffer,
-                            file_index_++);
+                            current_period_,
+                            file_index_++,
+                            extension_.c_str());
 
     // 检查是否发生截断（虽然不太可能）
     if (len > 0 && static_cast<size_t>(len) < sizeof(filepath_buffer)) {
@@ -81,12 +167,15 @@ void MMapFileWriter::generate_new_filepath() {
     } else {
         // 异常处理：如果路径太长，回退到 stringstream
         std::stringstream ss;
-        ss << log_dir_ << "/" << date_buffer << "_" << (file_index_ - 1) << ".log";
+        ss << log_dir_ << "/" << current_period_ << "_" << (file_index_ - 1) << extension_;
         current_filepath_ = ss.str();
     }
 }
 
 bool MMapFileWriter::open() {
+    std::string previous_filepath = std::move(current_filepath_);
+    // 段至少要放得下文件头和一页数据
+    file_size_ = std::max(next_file_size_, SEGMENT_HEADER_SIZE + 4096);
     generate_new_filepath();
     
     fd_ = ::open(current_filepath_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
@@ -114,15 +203,25 @@ bool MMapFileWriter::open() {
         return false;
     }
     
-    write_pos_ = 0;
+    format_segment_header(mapped_memory_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    write_pos_ = SEGMENT_HEADER_SIZE;
+    if (index_enabled_) {
+        open_index();
+    }
+    if (retention_) {
+        retention_->on_rotated(previous_filepath, current_filepath_);
+    }
     return true;
 }
 
 void MMapFileWriter::close() {
     if (mapped_memory_ != nullptr) {
+        store_segment_committed(mapped_memory_, write_pos_);
+        store_segment_closed(mapped_memory_);
         msync(mapped_memory_, write_pos_, MS_SYNC);
         
-        if (write_pos_ > 0 && write_pos_ < file_size_) {
+        if (write_pos_ < file_size_) {
             if (ftruncate(fd_, write_pos_) == -1) {
                 std::cerr << "Warning: Failed to truncate file to final size: " 
                           << std::strerror(errno) << std::endl;
@@ -137,37 +236,103 @@ void MMapFileWriter::close() {
         ::close(fd_);
         fd_ = -1;
     }
+
+    if (index_fd_ != -1) {
+        ::close(index_fd_);
+        index_fd_ = -1;
+    }
     
     // Don't reset file_size_ here, it's needed for the next file
     write_pos_ = 0;
 }
 
-bool MMapFileWriter::rotate_file() {
-    close();
-    return open();
+void MMapFileWriter::open_index() {
+    const std::string path = index_path_for(current_filepath_);
+    index_fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (index_fd_ == -1) [[unlikely]] {
+        std::cerr << "Failed to open index " << path << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    const IndexHeader header{INDEX_MAGIC, INDEX_VERSION, sizeof(IndexEntry), 0};
+    if (::write(index_fd_, &header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) [[unlikely]] {
+        ::close(index_fd_);
+        index_fd_ = -1;
+    }
 }
 
-bool MMapFileWriter::write(const char* data, size_t len) {
+void MMapFileWriter::append_index(const IndexEntry* entries, size_t count) {
+    if (index_fd_ == -1 || count == 0) {
+        return;
+    }
+    // 每次写出只有一次系统调用，条目很小，写失败只影响索引
+    const size_t bytes = count * sizeof(IndexEntry);
+    if (::write(index_fd_, entries, bytes) != static_cast<ssize_t>(bytes)) [[unlikely]] {
+        std::cerr << "Failed to append index: " << std::strerror(errno) << std::endl;
+    }
+}
+
+bool MMapFileWriter::write(const char* data, size_t len, IndexEntry* marks, size_t mark_count) {
     if (!is_open() || len == 0) [[unlikely]] {
         return false;
     }
-    
-    if (write_pos_ + len > file_size_) [[unlikely]] {
+    if (write_pos_ + len > file_size_ ||
+        (rotate_interval_ != RotateInterval::NONE && std::chrono::system_clock::now() >= next_rotation_)) [[unlikely]] {
         if (!rotate_file()) {
             return false;
         }
     }
-    
+
+    // 比整个文件还大的块跨文件拆分写入；标记按偏移递增，落在后一部分的标记写入新段的索引
+    size_t consumed = 0;
+    size_t next_mark = 0;
+    auto index_until = [&](size_t chunk_end) {
+        const size_t first = next_mark;
+        while (next_mark < mark_count && marks[next_mark].offset < chunk_end) {
+            marks[next_mark].offset = marks[next_mark].offset - consumed + write_pos_;
+            ++next_mark;
+        }
+        append_index(marks + first, next_mark - first);
+    };
+    while (len > file_size_ - write_pos_) [[unlikely]] {
+        const size_t chunk = file_size_ - write_pos_;
+        index_until(consumed + chunk);
+        std::memcpy(mapped_memory_ + write_pos_, data, chunk);
+        write_pos_ += chunk;
+        data += chunk;
+        len -= chunk;
+        consumed += chunk;
+        store_segment_committed(mapped_memory_, write_pos_);
+        if (!rotate_file()) {
+            return false;
+        }
+    }
+    index_until(consumed + len);
     std::memcpy(mapped_memory_ + write_pos_, data, len);
     write_pos_ += len;
-    
+    // 每批都是完整的记录，写完后才推进 committed，崩溃后不会留下半行
+    store_segment_committed(mapped_memory_, write_pos_);
     return true;
 }
 
+bool MMapFileWriter::rotate_file() {
+    close();
+    return open();
+}
+
+bool MMapFileWriter::write(const char* data, size_t len) {
+    return write(data, len, nullptr, 0);
+}
+
 void MMapFileWriter::flush() {
     if (is_open()) {
         msync(mapped_memory_, write_pos_, MS_ASYNC);
     }
 }
 
+void MMapFileWriter::sync() {
+    if (is_open()) {
+        msync(mapped_memory_, write_pos_, MS_SYNC);
+    }
+}
+
 }
\ No newline at end of file
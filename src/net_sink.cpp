@@ -0,0 +1,345 @@
+#include "../include/net_sink.h"
+#include "../include/lz_block.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace logF {
+
+namespace {
+
+constexpr uint64_t SPOOL_MAGIC = 0x314C4F4F5053464CULL;  // "LFSPOOL1"
+constexpr size_t SPOOL_META_BYTES = 4096;
+
+size_t frame_size(const char* frame) {
+    BatchHeader header;
+    std::memcpy(&header, frame, sizeof(header));
+    return sizeof(BatchHeader) + header.payload_len;
+}
+
+}
+
+bool resolve_endpoint(const std::string& endpoint, sockaddr_storage& addr, socklen_t& addr_len) {
+    std::memset(&addr, 0, sizeof(addr));
+    if (endpoint.rfind("unix://", 0) == 0) {
+        const std::string path = endpoint.substr(7);
+        auto* un = reinterpret_cast<sockaddr_un*>(&addr);
+        if (path.empty() || path.size() >= sizeof(un->sun_path)) {
+            return false;
+        }
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+        addr_len = static_cast<socklen_t>(sizeof(sockaddr_un));
+        return true;
+    }
+    if (endpoint.rfind("tcp://", 0) != 0) {
+        return false;
+    }
+    const std::string host_port = endpoint.substr(6);
+    const size_t colon = host_port.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        return false;
+    }
+    std::string host = host_port.substr(0, colon);
+    if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+        host = host.substr(1, host.size() - 2);  // [::1]:9700
+    }
+    const std::string port = host_port.substr(colon + 1);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr) {
+        return false;
+    }
+    std::memcpy(&addr, result->ai_addr, result->ai_addrlen);
+    addr_len = result->ai_addrlen;
+    ::freeaddrinfo(result);
+    return true;
+}
+
+FrameSpool::FrameSpool(const std::string& path, size_t capacity) : capacity_(capacity) {
+    mapped_bytes_ = SPOOL_META_BYTES + capacity_;
+    void* memory = MAP_FAILED;
+    if (path.empty()) {
+        memory = mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd == -1) [[unlikely]] {
+            std::cerr << "Failed to open spool " << path << ": " << std::strerror(errno) << std::endl;
+        } else {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == mapped_bytes_) {
+                memory = mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            } else if (ftruncate(fd, 0) == 0 && ftruncate(fd, static_cast<off_t>(mapped_bytes_)) == 0) {
+                memory = mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+        }
+    }
+    if (memory == MAP_FAILED) [[unlikely]] {
+        static Meta empty_meta{};
+        meta_ = &empty_meta;
+        return;
+    }
+    mapping_ = static_cast<char*>(memory);
+    meta_ = reinterpret_cast<Meta*>(mapping_);
+    data_ = mapping_ + SPOOL_META_BYTES;
+    // 上次进程留下的帧：头部完整、位置合法时继续发送，否则清空
+    const bool valid = meta_->magic == SPOOL_MAGIC && meta_->capacity == capacity_ &&
+                       meta_->head <= meta_->tail && meta_->tail - meta_->head <= capacity_;
+    if (!valid) {
+        meta_->magic = SPOOL_MAGIC;
+        meta_->capacity = capacity_;
+        meta_->head = meta_->tail = meta_->pad_start = 0;
+    }
+}
+
+FrameSpool::~FrameSpool() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapped_bytes_);
+    }
+}
+
+bool FrameSpool::push(const BatchHeader& header, const char* payload) {
+    if (data_ == nullptr) [[unlikely]] {
+        return false;
+    }
+    const size_t size = sizeof(BatchHeader) + header.payload_len;
+    uint64_t start = meta_->tail;
+    const size_t offset = static_cast<size_t>(start % capacity_);
+    if (offset + size > capacity_) {
+        start += capacity_ - offset;  // 末尾放不下，从下一圈开始
+    }
+    if (start + size - meta_->head > capacity_) {
+        return false;
+    }
+    if (start != meta_->tail) {
+        meta_->pad_start = meta_->tail;
+        if (meta_->head == meta_->tail) {
+            meta_->head = start;
+        }
+    }
+    char* dst = data_ + start % capacity_;
+    std::memcpy(dst, &header, sizeof(header));
+    std::memcpy(dst + sizeof(header), payload, header.payload_len);
+    meta_->tail = start + size;
+    if (meta_->tail % capacity_ == 0) {
+        meta_->pad_start = meta_->tail;  // 恰好写满一圈，读到这里同样跳到下一圈
+    }
+    return true;
+}
+
+size_t FrameSpool::front_size() const {
+    return empty() ? 0 : frame_size(data_ + meta_->head % capacity_);
+}
+
+void FrameSpool::pop_front() {
+    meta_->head += front_size();
+    if (meta_->head != meta_->tail && meta_->head == meta_->pad_start && meta_->head % capacity_ != 0) {
+        meta_->head += capacity_ - meta_->head % capacity_;
+    }
+}
+
+int FrameSpool::gather(size_t skip, iovec* iov) const {
+    if (empty()) {
+        return 0;
+    }
+    const uint64_t head = meta_->head;
+    const uint64_t tail = meta_->tail;
+    const uint64_t lap_end = head - head % capacity_ + capacity_;
+    if (tail <= lap_end) {
+        iov[0] = {data_ + head % capacity_ + skip, static_cast<size_t>(tail - head) - skip};
+        return 1;
+    }
+    // 数据跨圈：本圈到留空处为止，再加上下一圈开头
+    iov[0] = {data_ + head % capacity_ + skip, static_cast<size_t>(meta_->pad_start - head) - skip};
+    iov[1] = {data_, static_cast<size_t>(tail - lap_end)};
+    return 2;
+}
+
+NetworkSink::NetworkSink(const std::string& endpoint, LogLevel level, NetworkSinkOptions options)
+    : Sink(level), endpoint_(endpoint), options_(std::move(options)),
+      stream_(static_cast<uint32_t>(::getpid())),
+      spool_(options_.spool_path, options_.spool_bytes),
+      backoff_(options_.reconnect_min) {
+    batch_.reserve(options_.batch_bytes);
+    if (options_.compress) {
+        compressed_.resize(lz::compress_bound(options_.batch_bytes));
+    }
+    if (!spool_.ok()) [[unlikely]] {
+        std::cerr << "Network sink has no spool, records will be dropped" << std::endl;
+    }
+    try_connect();
+}
+
+NetworkSink::~NetworkSink() {
+    seal_batch();
+    // 尽量送出剩余的帧；文件 spool 中没送出的部分在下次启动时继续发送
+    const auto deadline = std::chrono::steady_clock::now() + options_.linger;
+    while (!spool_.empty() && std::chrono::steady_clock::now() < deadline) {
+        if (state_ != State::CONNECTED && !try_connect()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        send_pending();
+        if (state_ == State::CONNECTED && !spool_.empty()) {
+            pollfd pfd{fd_, POLLOUT, 0};
+            ::poll(&pfd, 1, 10);
+        }
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+void NetworkSink::write(const char* data, size_t len) {
+    if (!batch_.empty() && batch_.size() + len > options_.batch_bytes) {
+        seal_batch();
+    }
+    batch_.append(data, len);
+    ++batch_records_;
+}
+
+void NetworkSink::flush() {
+    seal_batch();
+    if (state_ != State::CONNECTED && !try_connect()) {
+        return;
+    }
+    send_pending();
+}
+
+void NetworkSink::seal_batch() {
+    if (batch_.empty()) {
+        return;
+    }
+    BatchHeader header{};
+    header.magic = BATCH_MAGIC;
+    header.raw_len = static_cast<uint32_t>(batch_.size());
+    header.records = batch_records_;
+    header.stream = stream_;
+    header.sequence = sequence_++;
+    const char* payload = batch_.data();
+    header.payload_len = header.raw_len;
+    if (options_.compress) {
+        compressed_.resize(std::max(compressed_.size(), lz::compress_bound(batch_.size())));
+        const size_t n = lz::compress(batch_.data(), batch_.size(), compressed_.data(), compressed_.size());
+        if (n > 0 && n < batch_.size()) {
+            header.flags = BATCH_COMPRESSED;
+            header.payload_len = static_cast<uint32_t>(n);
+            payload = compressed_.data();
+        }
+    }
+    if (!spool_.push(header, payload)) [[unlikely]] {
+        // 序号照常递增，收集端能看到缺口
+        dropped_records_ += batch_records_;
+    }
+    batch_.clear();
+    batch_records_ = 0;
+}
+
+bool NetworkSink::try_connect() {
+    if (state_ == State::CONNECTING) {
+        pollfd pfd{fd_, POLLOUT, 0};
+        if (::poll(&pfd, 1, 0) <= 0) {
+            return false;
+        }
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+            disconnect();
+            return false;
+        }
+    } else {
+        if (std::chrono::steady_clock::now() < next_connect_) {
+            return false;
+        }
+        if (!resolved_ && !(resolved_ = resolve_endpoint(endpoint_, addr_, addr_len_))) {
+            disconnect();
+            return false;
+        }
+        fd_ = ::socket(addr_.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd_ == -1) [[unlikely]] {
+            disconnect();
+            return false;
+        }
+        if (addr_.ss_family != AF_UNIX) {
+            int one = 1;
+            setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr_), addr_len_) != 0) {
+            if (errno == EINPROGRESS) {
+                state_ = State::CONNECTING;
+                return false;
+            }
+            disconnect();
+            return false;
+        }
+    }
+    state_ = State::CONNECTED;
+    backoff_ = options_.reconnect_min;
+    if (ever_connected_) {
+        ++reconnects_;
+    }
+    ever_connected_ = true;
+    return true;
+}
+
+void NetworkSink::disconnect() {
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    state_ = State::DISCONNECTED;
+    sent_in_front_ = 0;
+    next_connect_ = std::chrono::steady_clock::now() + backoff_;
+    backoff_ = std::min(backoff_ * 2, options_.reconnect_max);
+}
+
+void NetworkSink::send_pending() {
+    if (spool_.empty()) {
+        return;
+    }
+    // 收集端从不发数据：可读即对端已关闭，发送前先发现，避免写进一个即将被 RST 的连接
+    pollfd pfd{fd_, POLLIN | POLLRDHUP, 0};
+    if (::poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLIN | POLLRDHUP | POLLHUP | POLLERR))) {
+        disconnect();
+        return;
+    }
+    while (!spool_.empty()) {
+        iovec iov[2];
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(spool_.gather(sent_in_front_, iov));
+        const ssize_t n = ::sendmsg(fd_, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent_in_front_ += static_cast<size_t>(n);
+            while (!spool_.empty() && sent_in_front_ >= spool_.front_size()) {
+                sent_in_front_ -= spool_.front_size();
+                spool_.pop_front();
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;  // 对端读得慢，剩余部分留在 spool 中
+        }
+        disconnect();
+        return;
+    }
+}
+
+}
@@ -0,0 +1,186 @@
+#include "../include/retention.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+namespace logF {
+
+namespace {
+
+// YYYY-MM-DD 开头且包含 ".log"
+bool is_segment_name(const char* name) {
+    for (int i = 0; i < 10; ++i) {
+        const char c = name[i];
+        const bool ok = (i == 4 || i == 7) ? c == '-' : (c >= '0' && c <= '9');
+        if (!ok) return false;
+    }
+    return std::strstr(name + 10, ".log") != nullptr;
+}
+
+bool ends_with(const char* name, const char* suffix) {
+    const size_t n = std::strlen(name), m = std::strlen(suffix);
+    return n >= m && std::strcmp(name + n - m, suffix) == 0;
+}
+
+// 段的稀疏索引：X.log.idx / X.logz.idx；外部压缩后的 X.log.gz 仍对应 X.log.idx
+std::string index_companion(const std::string& path) {
+    const size_t pos = path.rfind(".log");
+    const size_t end = path.find('.', pos + 1);
+    return path.substr(0, end) + ".idx";
+}
+
+void lower_thread_priority() {
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#ifdef SYS_ioprio_set
+    constexpr int IOPRIO_WHO_PROCESS = 1;
+    constexpr int IOPRIO_CLASS_IDLE = 3;
+    constexpr int IOPRIO_CLASS_SHIFT = 13;
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+}
+
+}
+
+RetentionManager::RetentionManager(std::string log_dir, RetentionPolicy policy)
+    : log_dir_(std::move(log_dir)), policy_(std::move(policy)) {
+    thread_ = std::thread(&RetentionManager::run, this);
+}
+
+RetentionManager::~RetentionManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void RetentionManager::on_rotated(const std::string& closed_path, const std::string& active_path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!closed_path.empty() && !policy_.compress_command.empty()) {
+            closed_.push_back(closed_path);
+        }
+        active_path_ = active_path;
+        pending_ = true;
+    }
+    cv_.notify_one();
+}
+
+void RetentionManager::run() {
+    lower_thread_priority();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return pending_ || stopping_; });
+        if (stopping_) {
+            return;
+        }
+        pending_ = false;
+        while (!closed_.empty()) {
+            std::string path = std::move(closed_.front());
+            closed_.pop_front();
+            lock.unlock();
+            compress(path);
+            lock.lock();
+        }
+        lock.unlock();
+        enforce();
+        lock.lock();
+    }
+}
+
+void RetentionManager::compress(const std::string& path) {
+    // sh -c '<command> "$0"' <path>：路径作为参数传入，不经过 shell 拼接
+    const std::string script = policy_.compress_command + " \"$0\"";
+    char* argv[] = {const_cast<char*>("sh"), const_cast<char*>("-c"),
+                    const_cast<char*>(script.c_str()), const_cast<char*>(path.c_str()), nullptr};
+    pid_t pid;
+    if (posix_spawn(&pid, "/bin/sh", nullptr, nullptr, argv, environ) != 0) [[unlikely]] {
+        std::cerr << "Failed to run compress command for " << path << std::endl;
+        return;
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) [[unlikely]] {
+        std::cerr << "Compress command failed for " << path << std::endl;
+    }
+}
+
+void RetentionManager::enforce() {
+    if (policy_.max_total_bytes == 0 && policy_.max_files == 0) {
+        return;
+    }
+    std::string active;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active = active_path_;
+    }
+
+    struct Segment {
+        std::string path;
+        struct timespec mtime;
+        uint64_t bytes;
+    };
+    std::vector<Segment> segments;
+    uint64_t total_bytes = 0;
+    DIR* dir = opendir(log_dir_.c_str());
+    if (dir == nullptr) [[unlikely]] {
+        return;
+    }
+    while (dirent* entry = readdir(dir)) {
+        if (!is_segment_name(entry->d_name)) continue;
+        std::string path = log_dir_ + "/" + entry->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        const uint64_t bytes = static_cast<uint64_t>(st.st_size);
+        total_bytes += bytes;
+        if (ends_with(entry->d_name, ".idx")) {
+            continue;  // 随段一起删除
+        }
+        if (path != active) {
+            segments.push_back({std::move(path), st.st_mtim, bytes});
+        }
+    }
+    closedir(dir);
+
+    size_t file_count = segments.size() + (active.empty() ? 0 : 1);
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        if (a.mtime.tv_sec != b.mtime.tv_sec) return a.mtime.tv_sec < b.mtime.tv_sec;
+        if (a.mtime.tv_nsec != b.mtime.tv_nsec) return a.mtime.tv_nsec < b.mtime.tv_nsec;
+        return a.path < b.path;
+    });
+    for (const auto& segment : segments) {
+        const bool over_bytes = policy_.max_total_bytes != 0 && total_bytes > policy_.max_total_bytes;
+        const bool over_files = policy_.max_files != 0 && file_count > policy_.max_files;
+        if (!over_bytes && !over_files) {
+            break;
+        }
+        if (unlink(segment.path.c_str()) != 0) [[unlikely]] {
+            std::cerr << "Failed to remove " << segment.path << ": " << std::strerror(errno) << std::endl;
+            continue;
+        }
+        total_bytes -= segment.bytes;
+        --file_count;
+        const std::string index = index_companion(segment.path);
+        struct stat st;
+        if (stat(index.c_str(), &st) == 0 && unlink(index.c_str()) == 0) {
+            total_bytes -= static_cast<uint64_t>(st.st_size);
+        }
+    }
+}
+
+}
@@ -1,8 +1,12 @@
 #include "../include/ring_buffer.h"
 #include "../include/mmap_writer.h"
+#include <charconv>
 #include <cstddef> // For size_t
 #include <cstring> // For memcpy, strlen
 #include <cstdio>  // For snprintf
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace logF {
 
@@ -10,28 +14,12 @@ namespace logF {
 CharRingBuffer::CharRingBuffer(size_t capacity) 
     : capacity_(capacity), buffer_(capacity) {}
 
-void CharRingBuffer::append(const char* data, size_t len) {
-    if (write_pos_ + len >= capacity_) [[unlikely]] {
-        // Buffer would overflow, this shouldn't happen in normal usage
-        // For safety, just truncate
-        len = capacity_ - write_pos_ - 1;
-    }
-    std::memcpy(&buffer_[write_pos_], data, len);
-    write_pos_ += len;
-}
-
 void CharRingBuffer::append(const char* str) {
     if (str) [[likely]] {
         append(str, std::strlen(str));
     }
 }
 
-void CharRingBuffer::append(char c) {
-    if (write_pos_ < capacity_ - 1) [[likely]] {
-        buffer_[write_pos_++] = c;
-    }
-}
-
 void CharRingBuffer::append_number(long long num) {
     if (num == 0) {
         append('0');
@@ -56,6 +44,12 @@ void CharRingBuffer::append_number(long long num) {
     append(p, temp + sizeof(temp) - 1 - p);
 }
 
+void CharRingBuffer::append_number_exact(double num) {
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), num);
+    append(digits, result.ptr - digits);
+}
+
 void CharRingBuffer::append_number(double num) {
     // 科学计数法，保留四位有效数字
     if (num == 0.0) {
@@ -125,9 +119,108 @@ void CharRingBuffer::append_number(double num) {
     }
 }
 
+namespace {
+
+inline bool needs_json_escape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+// 第一个需要转义的字节的位置，没有则返回 end
+inline const char* find_json_escape(const char* p, const char* end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control_max = _mm_set1_epi8(0x1F);
+    for (; p + 16 <= end; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // 无符号比较 c <= 0x1F：max(c, 0x1F) == 0x1F
+        const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max);
+        const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(control, special));
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    while (p < end && !needs_json_escape(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    return p;
+}
+
+}
+
+void CharRingBuffer::append_json_escaped(const char* data, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    const char* p = data;
+    const char* const end = data + len;
+    while (p < end) {
+        const char* special = find_json_escape(p, end);
+        if (special > p) {
+            append(p, special - p);
+        }
+        if (special == end) {
+            break;
+        }
+        const unsigned char c = static_cast<unsigned char>(*special);
+        switch (c) {
+            case '"': append("\\\"", 2); break;
+            case '\\': append("\\\\", 2); break;
+            case '\n': append("\\n", 2); break;
+            case '\r': append("\\r", 2); break;
+            case '\t': append("\\t", 2); break;
+            default: {
+                const char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                append(escaped, sizeof(escaped));
+            }
+        }
+        p = special + 1;
+    }
+}
+
+void CharRingBuffer::append_json_escaped(const char* str) {
+    if (str) [[likely]] {
+        append_json_escaped(str, std::strlen(str));
+    }
+}
+
+void CharRingBuffer::append_hex(const uint8_t* data, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    if (write_pos_ + 2 * len >= capacity_) [[unlikely]] {
+        len = (capacity_ - write_pos_ - 1) / 2;
+    }
+    char* out = &buffer_[write_pos_];
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i digit = _mm_set1_epi8('0');
+    const __m128i letter_gap = _mm_set1_epi8('a' - '0' - 10);
+    for (; i + 16 <= len; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_mask);
+        __m128i lo = _mm_and_si128(bytes, low_mask);
+        // 半字节 n 转为 '0' + n，n > 9 时再加上 '0'..'a' 之间的间隔
+        hi = _mm_add_epi8(_mm_add_epi8(hi, digit), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letter_gap));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, digit), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letter_gap));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+    for (; i < len; ++i) {
+        out[2 * i] = hex[data[i] >> 4];
+        out[2 * i + 1] = hex[data[i] & 0xF];
+    }
+    write_pos_ += 2 * len;
+}
+
 void CharRingBuffer::flush_to_mmap(MMapFileWriter& writer) {
+    flush_to_mmap(writer, nullptr, 0);
+}
+
+void CharRingBuffer::flush_to_mmap(MMapFileWriter& writer, IndexEntry* marks, size_t mark_count) {
     if (write_pos_ > 0) [[likely]] {
-        writer.write(buffer_.data(), write_pos_);
+        writer.write(buffer_.data(), write_pos_, marks, mark_count);
         writer.write("\n", 1);
     }
 }
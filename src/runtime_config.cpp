@@ -0,0 +1,145 @@
+#include "../include/runtime_config.h"
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace logF {
+
+namespace {
+
+std::string trim(const std::string& s) {
+    const size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool parse_size(const std::string& value, size_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long n = std::strtoull(value.c_str(), &end, 10);
+    if (end == value.c_str() || errno != 0) {
+        return false;
+    }
+    switch (*end) {
+        case '\0': break;
+        case 'k': case 'K': n <<= 10; ++end; break;
+        case 'm': case 'M': n <<= 20; ++end; break;
+        case 'g': case 'G': n <<= 30; ++end; break;
+        default: return false;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    out = static_cast<size_t>(n);
+    return true;
+}
+
+}
+
+bool ConfigFileWatcher::load(const std::string& path, RuntimeConfig& config, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    RuntimeConfig parsed;
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        line = trim(line);
+        if (line.empty()) {
+            continue;
+        }
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            error = path + ":" + std::to_string(line_no) + ": expected key = value";
+            return false;
+        }
+        const std::string key = trim(line.substr(0, eq));
+        const std::string value = trim(line.substr(eq + 1));
+        bool ok = true;
+        if (key == "log_dir") {
+            parsed.log_dir = value;
+        } else if (key == "segment_size") {
+            ok = parse_size(value, parsed.segment_size) && parsed.segment_size > 0;
+        } else if (key == "output_format") {
+            if (value == "text") parsed.output_format = OutputFormat::TEXT;
+            else if (value == "json") parsed.output_format = OutputFormat::JSON;
+            else ok = false;
+        } else if (key == "wait_strategy") {
+            if (value == "sleep") parsed.wait_strategy = WaitStrategy::SLEEP;
+            else if (value == "yield") parsed.wait_strategy = WaitStrategy::YIELD;
+            else if (value == "spin") parsed.wait_strategy = WaitStrategy::BUSY_SPIN;
+            else ok = false;
+        } else if (key == "idle_sleep_us") {
+            size_t us = 0;
+            ok = parse_size(value, us);
+            parsed.idle_sleep = std::chrono::microseconds(us);
+        } else {
+            // 未知的键只提示，便于新旧版本共用同一份配置
+            std::cerr << path << ":" << line_no << ": unknown key '" << key << "' ignored" << std::endl;
+        }
+        if (!ok) {
+            error = path + ":" + std::to_string(line_no) + ": invalid value for " + key + ": '" + value + "'";
+            return false;
+        }
+    }
+    config = std::move(parsed);
+    return true;
+}
+
+ConfigFileWatcher::ConfigFileWatcher(std::string path, ConfigStore& store, std::chrono::milliseconds interval)
+    : path_(std::move(path)), store_(store), interval_(interval) {
+    poll();
+    thread_ = std::thread(&ConfigFileWatcher::run, this);
+}
+
+ConfigFileWatcher::~ConfigFileWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void ConfigFileWatcher::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, interval_, [this] { return stopping_; })) {
+        lock.unlock();
+        poll();
+        lock.lock();
+    }
+}
+
+void ConfigFileWatcher::poll() {
+    struct stat st;
+    if (::stat(path_.c_str(), &st) != 0) {
+        return;  // 文件暂时不存在（例如正在替换）时保留当前配置
+    }
+    const int64_t mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    if (mtime_ns == last_mtime_ns_ && st.st_size == last_size_) {
+        return;
+    }
+    last_mtime_ns_ = mtime_ns;
+    last_size_ = st.st_size;
+    RuntimeConfig config;
+    std::string error;
+    if (!load(path_, config, error)) {
+        std::cerr << "Config not applied: " << error << std::endl;
+        return;
+    }
+    store_.update(std::move(config));
+}
+
+}
@@ -0,0 +1,303 @@
+#include "../include/segment_header.h"
+#include "../include/lz_block.h"
+#include "../include/segment_index.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace logF {
+
+namespace {
+
+constexpr char HEADER_FORMAT[] = "#logF segment v%u pid=%010u created=%019lld committed=%016llu state=%c host=%.150s";
+constexpr size_t COMMITTED_OFFSET =
+    sizeof("#logF segment v1 pid=0000000000 created=0000000000000000000 committed=") - 1;
+constexpr size_t STATE_OFFSET = COMMITTED_OFFSET + sizeof("0000000000000000 state=") - 1;
+constexpr uint32_t SEGMENT_VERSION = 1;
+
+const std::string& host_name() {
+    static const std::string name = [] {
+        char buffer[256] = {};
+        if (gethostname(buffer, sizeof(buffer) - 1) != 0 || buffer[0] == '\0') {
+            return std::string("unknown");
+        }
+        return std::string(buffer);
+    }();
+    return name;
+}
+
+bool process_alive(uint32_t pid) {
+    return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+// 进程的启动时刻（开机以来的纳秒，/proc/<pid>/stat 第 22 项），读取失败返回 -1
+int64_t process_start_boot_ns(uint32_t pid) {
+    char path[32];
+    std::snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    char buffer[1024];
+    const ssize_t n = ::read(fd, buffer, sizeof(buffer) - 1);
+    ::close(fd);
+    if (n <= 0) {
+        return -1;
+    }
+    buffer[n] = '\0';
+    // 进程名可能含空格和括号，从最后一个 ')' 之后数：第 3 项是状态，第 22 项是启动时刻
+    const char* p = std::strrchr(buffer, ')');
+    if (p == nullptr) {
+        return -1;
+    }
+    for (int field = 2; field < 22 && p != nullptr; ++field) {
+        p = std::strchr(p + 1, ' ');
+    }
+    if (p == nullptr) {
+        return -1;
+    }
+    const long ticks_per_second = ::sysconf(_SC_CLK_TCK);
+    const unsigned long long ticks = std::strtoull(p + 1, nullptr, 10);
+    return ticks_per_second > 0 ? static_cast<int64_t>(ticks * 1000000000ULL / ticks_per_second) : -1;
+}
+
+int64_t clock_ns(clockid_t clock) {
+    timespec ts{};
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// 写入进程是否还在运行：pid 存在且启动早于段的创建时刻。容器里进程每次重启常常还是同一个 pid（例如 1），
+// 只看 pid 会把崩溃留下的段一直当作活跃。启动时刻只有时钟滴答精度，再留 1 秒余量应对时钟调整
+bool writer_alive(const SegmentInfo& info) {
+    if (!process_alive(info.pid)) {
+        return false;
+    }
+    const int64_t started = process_start_boot_ns(info.pid);
+    if (started < 0) {
+        return true;  // 无法判断时保守地当作存活
+    }
+    const int64_t created = info.created_ns - (clock_ns(CLOCK_REALTIME) - clock_ns(CLOCK_BOOTTIME));
+    return started <= created + 1000000000LL;
+}
+
+bool is_compressed(const std::string& path) {
+    return path.size() >= 5 && path.compare(path.size() - 5, 5, ".logz") == 0;
+}
+
+// 文本段：截到第一个 0 之前（掉电时可能有页没写回），再退到最后一个换行
+uint64_t valid_text_end(const char* data, uint64_t end) {
+    const char* begin = data + SEGMENT_HEADER_SIZE;
+    const void* zero = std::memchr(begin, '\0', end - SEGMENT_HEADER_SIZE);
+    if (zero != nullptr) {
+        end = static_cast<uint64_t>(static_cast<const char*>(zero) - data);
+    }
+    if (end > SEGMENT_HEADER_SIZE && data[end - 1] != '\n') {
+        const void* nl = memrchr(begin, '\n', end - SEGMENT_HEADER_SIZE);
+        end = nl ? static_cast<uint64_t>(static_cast<const char*>(nl) - data) + 1 : SEGMENT_HEADER_SIZE;
+    }
+    return end;
+}
+
+// 压缩段：保留完整的块帧
+uint64_t valid_block_end(const char* data, uint64_t end) {
+    uint64_t offset = SEGMENT_HEADER_SIZE;
+    while (offset + sizeof(BlockHeader) <= end) {
+        BlockHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        if (header.magic != BLOCK_MAGIC || header.compressed_len > end - offset - sizeof(header)) {
+            break;
+        }
+        offset += sizeof(header) + header.compressed_len;
+    }
+    return offset;
+}
+
+// 丢弃 .idx 中偏移不在段内的条目
+void trim_index(const std::string& segment_path, uint64_t end) {
+    const std::string path = index_path_for(segment_path);
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+    IndexEntry entry;
+    off_t keep = sizeof(IndexHeader);
+    while (pread(fd, &entry, sizeof(entry), keep) == static_cast<ssize_t>(sizeof(entry)) && entry.offset < end) {
+        keep += sizeof(entry);
+    }
+    if (ftruncate(fd, keep) != 0) {
+        std::cerr << "Failed to trim index " << path << ": " << std::strerror(errno) << std::endl;
+    }
+    ::close(fd);
+}
+
+void recover_one(const std::string& path, bool force, bool dry_run, RecoveryStats& stats) {
+    const int fd = ::open(path.c_str(), (dry_run ? O_RDONLY : O_RDWR) | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+    struct stat st;
+    char header[SEGMENT_HEADER_SIZE];
+    SegmentInfo info;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < SEGMENT_HEADER_SIZE ||
+        pread(fd, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        !parse_segment_header(header, sizeof(header), info)) {
+        ::close(fd);
+        return;
+    }
+    ++stats.scanned;
+    if (info.closed) {
+        ::close(fd);
+        return;
+    }
+    if (!force && (info.host != host_name() || writer_alive(info))) {
+        ++stats.skipped_live;
+        ::close(fd);
+        return;
+    }
+
+    const uint64_t size = static_cast<uint64_t>(st.st_size);
+    uint64_t end = std::clamp<uint64_t>(info.committed, SEGMENT_HEADER_SIZE, size);
+    if (end > SEGMENT_HEADER_SIZE) {
+        const uint64_t mapped_len = end;
+        void* mapped = mmap(nullptr, mapped_len, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Failed to map " << path << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            return;
+        }
+        const char* data = static_cast<const char*>(mapped);
+        end = is_compressed(path) ? valid_block_end(data, end) : valid_text_end(data, end);
+        munmap(mapped, mapped_len);
+    }
+
+    if (!dry_run) {
+        store_segment_committed(header, end);
+        store_segment_closed(header);
+        if (ftruncate(fd, static_cast<off_t>(end)) != 0 ||
+            pwrite(fd, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+            std::cerr << "Failed to recover " << path << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            return;
+        }
+        fdatasync(fd);
+        trim_index(path, end);
+    }
+    ::close(fd);
+    ++stats.recovered;
+    stats.trimmed_bytes += size - end;
+    std::cerr << (dry_run ? "Would recover " : "Recovered ") << path << ": " << (end - SEGMENT_HEADER_SIZE)
+              << " bytes kept, " << (size - end) << " trimmed (pid " << info.pid << ")" << std::endl;
+}
+
+}
+
+void format_segment_header(char* dst, int64_t created_ns) {
+    char buffer[SEGMENT_HEADER_SIZE + 1];
+    const int len = std::snprintf(buffer, sizeof(buffer), HEADER_FORMAT, SEGMENT_VERSION,
+                                  static_cast<unsigned>(::getpid()), static_cast<long long>(created_ns),
+                                  static_cast<unsigned long long>(SEGMENT_HEADER_SIZE), 'O', host_name().c_str());
+    std::memset(dst, ' ', SEGMENT_HEADER_SIZE);
+    std::memcpy(dst, buffer, std::min<size_t>(static_cast<size_t>(len), SEGMENT_HEADER_SIZE - 1));
+    dst[SEGMENT_HEADER_SIZE - 1] = '\n';
+}
+
+void store_segment_committed(char* header, uint64_t committed) {
+    char digits[16];
+    for (int i = 15; i >= 0; --i) {
+        digits[i] = static_cast<char>('0' + committed % 10);
+        committed /= 10;
+    }
+    std::memcpy(header + COMMITTED_OFFSET, digits, sizeof(digits));
+}
+
+void store_segment_closed(char* header) {
+    header[STATE_OFFSET] = 'C';
+}
+
+bool parse_segment_header(const char* data, size_t size, SegmentInfo& info) {
+    if (size < SEGMENT_HEADER_SIZE || std::memcmp(data, "#logF segment v", 15) != 0 ||
+        data[SEGMENT_HEADER_SIZE - 1] != '\n') {
+        return false;
+    }
+    char line[SEGMENT_HEADER_SIZE];
+    std::memcpy(line, data, SEGMENT_HEADER_SIZE - 1);
+    line[SEGMENT_HEADER_SIZE - 1] = '\0';
+    unsigned version = 0, pid = 0;
+    long long created = 0;
+    unsigned long long committed = 0;
+    char state = 0;
+    char host[151] = {};
+    if (std::sscanf(line, "#logF segment v%u pid=%u created=%lld committed=%llu state=%c host=%150s",
+                    &version, &pid, &created, &committed, &state, host) != 6 ||
+        (state != 'O' && state != 'C')) {
+        return false;
+    }
+    info.version = version;
+    info.pid = pid;
+    info.created_ns = created;
+    info.committed = committed;
+    info.closed = state == 'C';
+    info.host = host;
+    return true;
+}
+
+RecoveryStats recover_segments(const std::string& log_dir, unsigned threads, bool force, bool dry_run) {
+    std::vector<std::string> paths;
+    if (DIR* dir = opendir(log_dir.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name.find(".log") != std::string::npos &&
+                (name.size() < 4 || name.compare(name.size() - 4, 4, ".idx") != 0)) {
+                paths.push_back(log_dir + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+    RecoveryStats total;
+    if (paths.empty()) {
+        return total;
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, paths.size()));
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    auto work = [&] {
+        RecoveryStats local;
+        for (size_t i = next.fetch_add(1); i < paths.size(); i = next.fetch_add(1)) {
+            recover_one(paths[i], force, dry_run, local);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        total.scanned += local.scanned;
+        total.recovered += local.recovered;
+        total.skipped_live += local.skipped_live;
+        total.trimmed_bytes += local.trimmed_bytes;
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return total;
+}
+
+}
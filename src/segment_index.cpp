@@ -0,0 +1,58 @@
+#include "../include/segment_index.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace logF {
+
+bool SegmentIndex::load(const std::string& segment_path, uint64_t segment_size) {
+    entries_.clear();
+    segment_size_ = segment_size;
+    FILE* file = std::fopen(index_path_for(segment_path).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    IndexHeader header;
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == INDEX_MAGIC &&
+              header.version == INDEX_VERSION && header.entry_size == sizeof(IndexEntry);
+    if (ok) {
+        IndexEntry entry;
+        // 进程崩溃时最后一个条目可能不完整，或者指向尚未落盘的位置
+        while (std::fread(&entry, sizeof(entry), 1, file) == 1 && entry.offset < segment_size) {
+            entries_.push_back(entry);
+        }
+    }
+    std::fclose(file);
+
+    max_timestamp_.resize(entries_.size());
+    int64_t max_ts = INT64_MIN;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        max_ts = std::max(max_ts, entries_[i].first_timestamp_ns);
+        max_timestamp_[i] = max_ts;
+    }
+    for (size_t level = 0; level < LOG_LEVEL_COUNT; ++level) {
+        auto& prefix = level_prefix_[level];
+        prefix.assign(entries_.size() + 1, 0);
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            prefix[i + 1] = prefix[i] + entries_[i].level_counts[level];
+        }
+    }
+    return ok;
+}
+
+size_t SegmentIndex::seek(int64_t timestamp_ns) const {
+    // 第一个首时间戳（前缀最大值）大于目标的条目之前的那个条目
+    auto it = std::upper_bound(max_timestamp_.begin(), max_timestamp_.end(), timestamp_ns);
+    return it == max_timestamp_.begin() ? 0 : static_cast<size_t>(it - max_timestamp_.begin()) - 1;
+}
+
+size_t SegmentIndex::next_with_level(size_t from, LogLevel level) const {
+    const auto& prefix = level_prefix_[static_cast<size_t>(level)];
+    if (from >= entries_.size()) {
+        return entries_.size();
+    }
+    // prefix[j + 1] > prefix[from] 的最小 j
+    auto it = std::upper_bound(prefix.begin() + from + 1, prefix.end(), prefix[from]);
+    return it == prefix.end() ? entries_.size() : static_cast<size_t>(it - prefix.begin()) - 1;
+}
+
+}
@@ -0,0 +1,167 @@
+#include "../include/sink.h"
+#include "../include/segment_header.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace logF {
+
+namespace {
+
+// 写完整个缓冲区，被信号打断时重试
+void write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        const ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+}
+
+FileSink::FileSink(const std::string& log_dir, LogLevel level, size_t file_size, const std::string& extension)
+    : Sink(level), writer_(log_dir, file_size) {
+    writer_.set_file_extension(extension);
+    recover_segments(log_dir);
+    if (!writer_.open()) [[unlikely]] {
+        std::cerr << "Failed to open file sink in " << log_dir << std::endl;
+    }
+}
+
+void FileSink::flush() {
+    if (!buffer_.empty()) {
+        writer_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+}
+
+void ConsoleSink::flush() {
+    if (!buffer_.empty()) {
+        write_all(fd_, buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+}
+
+UnixSocketSink::UnixSocketSink(const std::string& path, LogLevel level, size_t max_pending)
+    : Sink(level), path_(path), max_pending_(max_pending) {
+    connect();
+}
+
+UnixSocketSink::~UnixSocketSink() {
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+bool UnixSocketSink::connect() {
+    next_connect_ = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    sockaddr_un addr{};
+    if (path_.size() >= sizeof(addr.sun_path)) [[unlikely]] {
+        return false;
+    }
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ == -1) [[unlikely]] {
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void UnixSocketSink::write(const char* data, size_t len) {
+    if (pending_.size() + len > max_pending_) [[unlikely]] {
+        ++dropped_;
+        return;
+    }
+    pending_.append(data, len);
+}
+
+void UnixSocketSink::flush() {
+    if (pending_.empty()) {
+        return;
+    }
+    if (fd_ == -1 && (std::chrono::steady_clock::now() < next_connect_ || !connect())) {
+        return;
+    }
+    size_t sent = 0;
+    while (sent < pending_.size()) {
+        const ssize_t n = ::send(fd_, pending_.data() + sent, pending_.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;  // 对端读得慢，剩余部分下次再发
+        }
+        ::close(fd_);
+        fd_ = -1;
+        break;
+    }
+    pending_.erase(0, sent);
+}
+
+AsyncSink::AsyncSink(std::unique_ptr<Sink> inner, size_t buffer_bytes)
+    : Sink(inner->level()), inner_(std::move(inner)), capacity_(buffer_bytes) {
+    front_.reserve(capacity_);
+    back_.reserve(capacity_);
+    thread_ = std::thread(&AsyncSink::run, this);
+}
+
+AsyncSink::~AsyncSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void AsyncSink::write(const char* data, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (front_.size() + len > capacity_) [[unlikely]] {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    front_.append(data, len);
+}
+
+void AsyncSink::flush() {
+    cv_.notify_one();
+}
+
+void AsyncSink::run() {
+    while (true) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::milliseconds(100), [this] { return stopping_ || !front_.empty(); });
+            stopping = stopping_;
+            front_.swap(back_);
+        }
+        if (!back_.empty()) {
+            inner_->write(back_.data(), back_.size());
+            back_.clear();
+        }
+        inner_->flush();
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+}
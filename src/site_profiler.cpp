@@ -0,0 +1,66 @@
+#include "../include/site_profiler.h"
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+
+namespace logF {
+
+bool SiteProfiler::enable(const std::string& stats_path, std::chrono::milliseconds interval, size_t top_n) {
+    out_.open(stats_path, std::ios::app);
+    if (!out_.is_open()) [[unlikely]] {
+        return false;
+    }
+    by_site_.assign(MAX_CALL_SITES, Entry());
+    interval_ = interval;
+    top_n_ = top_n;
+    next_report_ = std::chrono::steady_clock::now() + interval_;
+    enabled_ = true;
+    return true;
+}
+
+void SiteProfiler::report() {
+    std::vector<const Entry*> entries;
+    uint64_t total_count = 0;
+    uint64_t total_bytes = 0;
+    auto collect = [&](const Entry& entry) {
+        if (entry.count == 0) return;
+        entries.push_back(&entry);
+        total_count += entry.count;
+        total_bytes += entry.bytes;
+    };
+    for (const auto& entry : by_site_) collect(entry);
+    for (const auto& [key, entry] : overflow_) collect(entry);
+    if (entries.empty()) {
+        return;
+    }
+
+    const size_t n = std::min(top_n_, entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + n, entries.end(),
+                      [](const Entry* a, const Entry* b) { return a->count > b->count; });
+
+    std::time_t now = std::time(nullptr);
+    char time_str[32];
+    std::strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+    out_ << "==== " << time_str << " messages " << total_count << " bytes " << total_bytes
+         << " sites " << entries.size() << " ====\n";
+    out_ << std::left << std::setw(10) << "count" << std::setw(8) << "share" << std::setw(12) << "bytes"
+         << std::setw(10) << "avg_ns" << "site / format\n";
+    for (size_t i = 0; i < n; ++i) {
+        const Entry& entry = *entries[i];
+        const CallSite* site = call_sites_.site(entry.site_id);
+        const double share = 100.0 * entry.count / total_count;
+        out_ << std::left << std::setw(10) << entry.count
+             << std::setw(8) << (std::to_string(static_cast<int>(share + 0.5)) + "%")
+             << std::setw(12) << entry.bytes
+             << std::setw(10) << entry.format_ns / entry.count
+             << site->file() << ":" << site->line() << " \"" << entry.format << "\"\n";
+    }
+    out_.flush();
+
+    for (auto& entry : by_site_) {
+        entry.count = entry.bytes = entry.format_ns = 0;
+    }
+    overflow_.clear();
+}
+
+}
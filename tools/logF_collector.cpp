@@ -0,0 +1,242 @@
+// 网络 sink 的参考收集端。
+//   logF_collector --listen tcp://127.0.0.1:9700            记录输出到标准输出
+//   logF_collector --listen unix:///tmp/logF.sock --out DIR  写入 DIR 下的段文件
+//   --expect N   收到 N 条记录后退出，被信号中断时未收齐返回非 0（测试用）
+//   --quiet      不输出记录，只统计
+// 按帧接收批次并解压，按发送进程（stream）检查序号；退出时在标准错误输出连接数、批次、记录数和缺失的批次。
+
+#include "../include/lz_block.h"
+#include "../include/mmap_writer.h"
+#include "../include/net_sink.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void on_signal(int) { stop_requested = 1; }
+
+struct Connection {
+    int fd;
+    std::vector<char> buffer;
+    size_t begin = 0;   // 尚未解析的数据起点
+};
+
+struct Stats {
+    uint64_t connections = 0;
+    uint64_t batches = 0;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t missing_batches = 0;
+    uint64_t duplicate_batches = 0;
+    uint64_t bad_frames = 0;
+};
+
+class Collector {
+public:
+    Collector(std::unique_ptr<logF::MMapFileWriter> writer, bool quiet) : writer_(std::move(writer)), quiet_(quiet) {}
+
+    // 解析连接缓冲区中完整的帧；格式错误时返回 false，调用方断开连接
+    bool consume(Connection& conn) {
+        while (conn.buffer.size() - conn.begin >= sizeof(logF::BatchHeader)) {
+            logF::BatchHeader header;
+            std::memcpy(&header, conn.buffer.data() + conn.begin, sizeof(header));
+            if (header.magic != logF::BATCH_MAGIC || header.payload_len > logF::MAX_BATCH_PAYLOAD ||
+                header.raw_len > logF::MAX_BATCH_PAYLOAD) {
+                ++stats_.bad_frames;
+                return false;
+            }
+            if (conn.buffer.size() - conn.begin < sizeof(header) + header.payload_len) {
+                break;
+            }
+            const char* payload = conn.buffer.data() + conn.begin + sizeof(header);
+            if (!handle(header, payload)) {
+                ++stats_.bad_frames;
+                return false;
+            }
+            conn.begin += sizeof(header) + header.payload_len;
+        }
+        // 已解析的部分移出缓冲区
+        conn.buffer.erase(conn.buffer.begin(), conn.buffer.begin() + static_cast<std::ptrdiff_t>(conn.begin));
+        conn.begin = 0;
+        return true;
+    }
+
+    Stats& stats() { return stats_; }
+
+    void close() {
+        if (writer_) writer_->close();
+    }
+
+private:
+    bool handle(const logF::BatchHeader& header, const char* payload) {
+        const char* data = payload;
+        if (header.flags & logF::BATCH_COMPRESSED) {
+            raw_.resize(header.raw_len);
+            if (!logF::lz::decompress(payload, header.payload_len, raw_.data(), header.raw_len)) {
+                return false;
+            }
+            data = raw_.data();
+        } else if (header.raw_len != header.payload_len) {
+            return false;
+        }
+        auto it = next_sequence_.find(header.stream);
+        if (it != next_sequence_.end()) {
+            if (header.sequence < it->second) {
+                ++stats_.duplicate_batches;
+                return true;
+            }
+            stats_.missing_batches += header.sequence - it->second;
+        }
+        next_sequence_[header.stream] = header.sequence + 1;
+        ++stats_.batches;
+        stats_.records += header.records;
+        stats_.bytes += header.raw_len;
+        if (quiet_) {
+            return true;
+        }
+        if (writer_) {
+            writer_->write(data, header.raw_len);
+        } else {
+            std::fwrite(data, 1, header.raw_len, stdout);
+        }
+        return true;
+    }
+
+    std::unique_ptr<logF::MMapFileWriter> writer_;
+    bool quiet_;
+    std::vector<char> raw_;
+    std::map<uint32_t, uint64_t> next_sequence_;
+    Stats stats_;
+};
+
+int listen_on(const std::string& endpoint) {
+    sockaddr_storage addr;
+    socklen_t addr_len = 0;
+    if (!logF::resolve_endpoint(endpoint, addr, addr_len)) {
+        std::cerr << "Invalid endpoint: " << endpoint << std::endl;
+        return -1;
+    }
+    if (addr.ss_family == AF_UNIX) {
+        ::unlink(reinterpret_cast<sockaddr_un*>(&addr)->sun_path);
+    }
+    const int fd = ::socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0 || ::listen(fd, 64) != 0) {
+        std::cerr << "Cannot listen on " << endpoint << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string endpoint;
+    std::string out_dir;
+    uint64_t expect = 0;
+    bool quiet = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--listen" && i + 1 < argc) endpoint = argv[++i];
+        else if (arg == "--out" && i + 1 < argc) out_dir = argv[++i];
+        else if (arg == "--expect" && i + 1 < argc) expect = std::stoull(argv[++i]);
+        else if (arg == "--quiet") quiet = true;
+        else {
+            std::cerr << "Usage: " << argv[0] << " --listen tcp://HOST:PORT|unix:///PATH [--out DIR] [--expect N] [--quiet]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (endpoint.empty()) {
+        std::cerr << "--listen is required" << std::endl;
+        return 1;
+    }
+    const int listen_fd = listen_on(endpoint);
+    if (listen_fd == -1) {
+        return 1;
+    }
+    std::unique_ptr<logF::MMapFileWriter> writer;
+    if (!out_dir.empty()) {
+        writer = std::make_unique<logF::MMapFileWriter>(out_dir, 64 * 1024 * 1024);
+        if (!writer->open()) {
+            std::cerr << "Cannot open output directory " << out_dir << std::endl;
+            return 1;
+        }
+    }
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    Collector collector(std::move(writer), quiet);
+    std::vector<Connection> connections;
+    std::vector<pollfd> fds;
+    char chunk[64 * 1024];
+    while (!stop_requested && (expect == 0 || collector.stats().records < expect)) {
+        fds.clear();
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const auto& conn : connections) {
+            fds.push_back({conn.fd, POLLIN, 0});
+        }
+        if (::poll(fds.data(), fds.size(), 200) <= 0) {
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            const int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd != -1) {
+                connections.push_back({fd, {}, 0});
+                ++collector.stats().connections;
+            }
+        }
+        for (size_t i = 1; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            Connection& conn = connections[i - 1];
+            const ssize_t n = ::recv(conn.fd, chunk, sizeof(chunk), 0);
+            bool keep = n > 0 || (n < 0 && errno == EINTR);
+            if (n > 0) {
+                conn.buffer.insert(conn.buffer.end(), chunk, chunk + n);
+                keep = collector.consume(conn);
+            }
+            if (!keep) {
+                // 未收完的帧随连接一起丢弃，发送端会整帧重发
+                ::close(conn.fd);
+                conn.fd = -1;
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                         [](const Connection& conn) { return conn.fd == -1; }),
+                          connections.end());
+    }
+    for (const auto& conn : connections) {
+        ::close(conn.fd);
+    }
+    ::close(listen_fd);
+    collector.close();
+    if (!quiet) {
+        std::fflush(stdout);
+    }
+    const Stats& s = collector.stats();
+    std::cerr << "connections " << s.connections << ", batches " << s.batches << ", records " << s.records
+              << ", bytes " << s.bytes << ", missing batches " << s.missing_batches << ", duplicate batches "
+              << s.duplicate_batches << ", bad frames " << s.bad_frames << std::endl;
+    const bool complete = expect == 0 || s.records >= expect;
+    return complete && s.missing_batches == 0 && s.bad_frames == 0 ? 0 : 2;
+}
@@ -0,0 +1,139 @@
+// 压缩段解码工具。
+//   logF_decode FILE...                    解压所有块，按顺序输出文本
+//   logF_decode --list FILE...             列出块：偏移、第一条日志时间、压缩前后长度
+//   logF_decode --block N FILE             只解压第 N 个块（从 0 开始）
+//   logF_decode --threads N FILE...        并行解压（默认使用全部核心）
+// 块之间相互独立，先顺序扫描帧头得到块表，再分批并行解压、按顺序写出。
+
+#include "segment_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using tools::Block;
+using tools::MappedFile;
+
+std::string format_time(int64_t ns) {
+    const time_t seconds = static_cast<time_t>(ns / 1000000000);
+    std::tm tm = *std::localtime(&seconds);
+    char buffer[40];
+    const size_t len = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+    std::snprintf(buffer + len, sizeof(buffer) - len, ".%03lld", static_cast<long long>(ns / 1000000 % 1000));
+    return buffer;
+}
+
+bool decode_range(const MappedFile& file, const std::vector<Block>& blocks, size_t first, size_t last, unsigned threads) {
+    constexpr size_t BATCH_PER_THREAD = 4;
+    const size_t batch = std::max<size_t>(1, threads * BATCH_PER_THREAD);
+    std::vector<std::vector<char>> outputs(batch);
+    std::vector<char> ok(batch);
+    bool all_ok = true;
+    for (size_t start = first; start < last; start += batch) {
+        const size_t count = std::min(batch, last - start);
+        auto work = [&](unsigned worker) {
+            for (size_t i = worker; i < count; i += threads) {
+                const Block& block = blocks[start + i];
+                outputs[i].resize(block.header.uncompressed_len);
+                ok[i] = logF::decode_block(block.header, file.data() + block.offset + sizeof(logF::BlockHeader),
+                                           outputs[i].data());
+            }
+        };
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t) workers.emplace_back(work, t);
+        work(0);
+        for (auto& worker : workers) worker.join();
+        for (size_t i = 0; i < count; ++i) {
+            if (!ok[i]) {
+                std::cerr << "corrupt block " << start + i << " at offset " << blocks[start + i].offset << std::endl;
+                all_ok = false;
+                continue;
+            }
+            std::fwrite(outputs[i].data(), 1, outputs[i].size(), stdout);
+        }
+    }
+    return all_ok;
+}
+
+}
+
+int main(int argc, char** argv) {
+    bool list = false;
+    long block_index = -1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--list") {
+            list = true;
+        } else if (arg == "--block" && i + 1 < argc) {
+            block_index = std::stol(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (!arg.empty() && arg[0] != '-') {
+            files.push_back(arg);
+        } else {
+            files.clear();
+            break;
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--list] [--block N] [--threads N] FILE..." << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    for (const auto& path : files) {
+        MappedFile file(path);
+        if (!file.ok()) {
+            std::cerr << "cannot open " << path << std::endl;
+            ok = false;
+            continue;
+        }
+        bool truncated = false;
+        const tools::SegmentRange range = tools::segment_range(path, file.data(), file.size());
+        const std::vector<Block> blocks = tools::scan_blocks(file.data(), range.begin, range.end, truncated);
+        if (truncated) {
+            std::cerr << path << ": stopped at a damaged frame after " << blocks.size() << " blocks" << std::endl;
+            ok = false;
+        }
+
+        if (list) {
+            uint64_t raw = 0, stored = 0;
+            std::printf("%s\n%-6s %-12s %-24s %12s %12s %7s\n", path.c_str(), "block", "offset", "first",
+                        "raw", "stored", "ratio");
+            for (size_t i = 0; i < blocks.size(); ++i) {
+                const auto& h = blocks[i].header;
+                raw += h.uncompressed_len;
+                stored += h.compressed_len;
+                std::printf("%-6zu %-12zu %-24s %12u %12u %7.2f%s\n", i, blocks[i].offset,
+                            format_time(h.first_timestamp_ns).c_str(), h.uncompressed_len, h.compressed_len,
+                            h.compressed_len ? static_cast<double>(h.uncompressed_len) / h.compressed_len : 0.0,
+                            (h.flags & logF::BLOCK_RAW) ? " raw" : "");
+            }
+            std::printf("total  %zu blocks %12llu %12llu %7.2f\n", blocks.size(),
+                        static_cast<unsigned long long>(raw), static_cast<unsigned long long>(stored),
+                        stored ? static_cast<double>(raw) / stored : 0.0);
+            continue;
+        }
+
+        if (block_index >= 0) {
+            if (static_cast<size_t>(block_index) >= blocks.size()) {
+                std::cerr << path << ": only " << blocks.size() << " blocks" << std::endl;
+                ok = false;
+                continue;
+            }
+            ok &= decode_range(file, blocks, block_index, block_index + 1, 1);
+        } else {
+            ok &= decode_range(file, blocks, 0, blocks.size(), threads);
+        }
+    }
+    std::fflush(stdout);
+    return ok ? 0 : 1;
+}
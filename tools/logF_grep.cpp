@@ -0,0 +1,589 @@
+// logF 段的并行检索与跟踪工具。
+//   logF_grep [选项] PATH...        PATH 为段文件或日志目录（目录按时间顺序展开其中的段）
+//     -e TEXT                      包含子串
+//     -E REGEX                     ECMAScript 正则（先用其中必需的字面量预过滤）
+//     --level LEVEL                最低级别：TRACE/DEBUG/INFO/WARNING/ERROR
+//     --site FILE[:LINE]           调用点
+//     --from TIME / --to TIME      时间范围，HH:MM:SS[.mmm] 或 YYYY-MM-DD HH:MM:SS[.mmm]（也可用 T 分隔）
+//     -c                           只输出匹配行数
+//     -H / -h                      强制 / 不输出文件名前缀（默认多个段时输出）
+//     -f                           跟踪最新的段，实时输出新的匹配行（目录下出现新段时自动切换）
+//     --threads N                  并行线程数，默认使用全部核心
+// 文本段按行边界切分给多个线程，压缩段（.logz）按块并行解压；有 .idx 索引或块时间戳时先按时间范围裁剪。
+// 未关闭的文本段末尾的 0 填充会被跳过。日志行只有时分秒，日期取自段文件名。
+
+#include "segment_file.h"
+#include "../include/segment_index.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr int64_t MS_PER_DAY = 86400000;
+constexpr int64_t REORDER_SLACK_MS = 1000;   // 多个生产者的时间戳在段内只是近似有序
+constexpr size_t MIN_CHUNK = 1 << 20;
+
+const char* const LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR"};
+
+// ---------------------------------------------------------------- 字面量查找
+
+// 首尾字符同时比较的 SIMD 预过滤（每次 16/32 个候选位置），命中后再 memcmp 校验中间部分
+const char* find_literal(const char* p, const char* end, const std::string& needle) {
+    const size_t n = needle.size();
+    if (static_cast<size_t>(end - p) < n) return nullptr;
+    if (n == 1) return static_cast<const char*>(std::memchr(p, needle[0], end - p));
+#if defined(__AVX2__)
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+    for (; p + n - 1 + 32 <= end; p += 32) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + n - 1));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while (mask != 0) {
+            const int bit = __builtin_ctz(mask);
+            if (std::memcmp(p + bit + 1, needle.data() + 1, n - 2) == 0) return p + bit;
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[n - 1]);
+    for (; p + n - 1 + 16 <= end; p += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n - 1));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask != 0) {
+            const int bit = __builtin_ctz(mask);
+            if (std::memcmp(p + bit + 1, needle.data() + 1, n - 2) == 0) return p + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    return static_cast<const char*>(memmem(p, end - p, needle.data(), n));
+}
+
+// 正则中每个匹配都必须包含的最长字面量；含分支、分组或字符类时放弃
+std::string required_literal(const std::string& regex) {
+    if (regex.find_first_of("|()[]") != std::string::npos) return std::string();
+    std::string best, run;
+    auto finish = [&]() {
+        if (run.size() > best.size()) best = run;
+        run.clear();
+    };
+    for (size_t i = 0; i < regex.size(); ++i) {
+        const char c = regex[i];
+        if (std::strchr("\\^$.*+?{}", c) == nullptr) {
+            run += c;
+            continue;
+        }
+        // 后面跟 ? * { 的字符是可选的
+        if ((c == '?' || c == '*' || c == '{') && !run.empty()) run.pop_back();
+        finish();
+        if (c == '\\') ++i;
+        // {m,n} 中的数字和逗号不是字面量
+        if (c == '{') {
+            const size_t close = regex.find('}', i);
+            if (close == std::string::npos) return std::string();
+            i = close;
+        }
+    }
+    finish();
+    return best.size() >= 2 ? best : std::string();
+}
+
+// ---------------------------------------------------------------- 时间
+
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+bool parse_date(const char* s, int64_t& day) {
+    int y, m, d;
+    if (std::sscanf(s, "%4d-%2d-%2d", &y, &m, &d) != 3) return false;
+    day = days_from_civil(y, m, d);
+    return true;
+}
+
+// HH:MM:SS[.mmm] → 当天毫秒数
+bool parse_time_of_day(const char* s, size_t len, int64_t& ms) {
+    if (len < 8 || s[2] != ':' || s[5] != ':') return false;
+    auto digit = [&](size_t i) { return s[i] >= '0' && s[i] <= '9' ? s[i] - '0' : -1; };
+    for (size_t i : {0, 1, 3, 4, 6, 7}) {
+        if (digit(i) < 0) return false;
+    }
+    ms = ((digit(0) * 10 + digit(1)) * 3600 + (digit(3) * 10 + digit(4)) * 60 + digit(6) * 10 + digit(7)) * 1000LL;
+    if (len >= 12 && s[8] == '.' && digit(9) >= 0 && digit(10) >= 0 && digit(11) >= 0) {
+        ms += digit(9) * 100 + digit(10) * 10 + digit(11);
+    }
+    return true;
+}
+
+struct TimeBound {
+    bool set = false;
+    bool has_date = false;
+    int64_t day = 0;
+    int64_t ms = 0;
+};
+
+bool parse_bound(const std::string& arg, TimeBound& bound) {
+    bound.set = true;
+    std::string time = arg;
+    if (arg.size() > 11 && arg[4] == '-' && (arg[10] == ' ' || arg[10] == 'T')) {
+        if (!parse_date(arg.c_str(), bound.day)) return false;
+        bound.has_date = true;
+        time = arg.substr(11);
+    }
+    return parse_time_of_day(time.c_str(), time.size(), bound.ms);
+}
+
+// 本地日期 day 的 ms 毫秒对应的 Unix 纳秒
+int64_t local_epoch_ns(int64_t day, int64_t ms) {
+    std::tm tm{};
+    const time_t t = static_cast<time_t>(day * 86400);
+    gmtime_r(&t, &tm);
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return (static_cast<int64_t>(std::mktime(&tm)) * 1000 + ms) * 1000000;
+}
+
+// ---------------------------------------------------------------- 过滤
+
+struct Filter {
+    std::string literal;
+    std::optional<std::regex> regex;
+    int min_level = -1;
+    std::string site_file;
+    long site_line = -1;
+    TimeBound from, to;
+
+    bool needs_prefix() const { return min_level >= 0 || !site_file.empty() || from.set || to.set; }
+};
+
+struct Segment {
+    std::string path;
+    std::string display;       // 输出前缀，空表示不输出
+    bool has_date = false;
+    int64_t day = 0;
+    std::unique_ptr<tools::MappedFile> file;
+};
+
+bool within(const TimeBound& bound, const Segment& segment, int64_t line_ms, bool lower) {
+    int64_t key = line_ms, limit = bound.ms;
+    if (bound.has_date && segment.has_date) {
+        key += segment.day * MS_PER_DAY;
+        limit += bound.day * MS_PER_DAY;
+    }
+    return lower ? key >= limit : key <= limit;
+}
+
+// 行格式：HH:MM:SS.mmm [LEVEL] [thread k=v] file:line message，线程上下文只在设置过时出现
+bool match_line(const char* b, const char* e, const Filter& filter, const Segment& segment) {
+    if (filter.needs_prefix()) {
+        int64_t line_ms;
+        if (!parse_time_of_day(b, e - b, line_ms)) return false;
+        if (filter.from.set && !within(filter.from, segment, line_ms, true)) return false;
+        if (filter.to.set && !within(filter.to, segment, line_ms, false)) return false;
+
+        const char* open = static_cast<const char*>(std::memchr(b + 8, '[', std::min<ptrdiff_t>(8, e - b - 8)));
+        const char* close = open ? static_cast<const char*>(std::memchr(open, ']', std::min<ptrdiff_t>(10, e - open))) : nullptr;
+        if (close == nullptr) return false;
+        if (filter.min_level >= 0) {
+            int level = -1;
+            for (int i = 0; i < 5; ++i) {
+                if (static_cast<size_t>(close - open - 1) == std::strlen(LEVEL_NAMES[i]) &&
+                    std::memcmp(open + 1, LEVEL_NAMES[i], close - open - 1) == 0) {
+                    level = i;
+                }
+            }
+            if (level < filter.min_level) return false;
+        }
+        if (!filter.site_file.empty()) {
+            const char* site = close + 2;
+            if (site >= e) return false;
+            if (*site == '[') {
+                // 跳过线程上下文
+                const char* ctx_end = static_cast<const char*>(memmem(site, e - site, "] ", 2));
+                if (ctx_end == nullptr) return false;
+                site = ctx_end + 2;
+            }
+            const char* site_end = static_cast<const char*>(std::memchr(site, ' ', e - site));
+            if (site_end == nullptr) site_end = e;
+            const char* colon = static_cast<const char*>(std::memchr(site, ':', site_end - site));
+            if (colon == nullptr) return false;
+            if (static_cast<size_t>(colon - site) != filter.site_file.size() ||
+                std::memcmp(site, filter.site_file.data(), colon - site) != 0) {
+                return false;
+            }
+            if (filter.site_line >= 0 && std::strtol(colon + 1, nullptr, 10) != filter.site_line) return false;
+        }
+    }
+    if (filter.regex && !std::regex_search(b, e, *filter.regex)) return false;
+    return true;
+}
+
+struct Output {
+    std::string text;
+    uint64_t count = 0;
+};
+
+void emit(const char* b, const char* e, const Segment& segment, bool count_only, Output& out) {
+    ++out.count;
+    if (count_only) return;
+    if (!segment.display.empty()) {
+        out.text += segment.display;
+        out.text += ':';
+    }
+    out.text.append(b, e - b);
+    out.text += '\n';
+}
+
+// 在 [begin, end) 中查找匹配行；有字面量时跳过不含它的行，不逐行解析
+void search_text(const char* begin, const char* end, const Filter& filter, const Segment& segment,
+                 bool count_only, Output& out) {
+    const char* p = begin;
+    while (p < end) {
+        const char* line_b = p;
+        if (!filter.literal.empty()) {
+            const char* hit = find_literal(p, end, filter.literal);
+            if (hit == nullptr) return;
+            const void* nl = memrchr(p, '\n', hit - p);
+            line_b = nl ? static_cast<const char*>(nl) + 1 : p;
+        }
+        const char* line_e = static_cast<const char*>(std::memchr(line_b, '\n', end - line_b));
+        if (line_e == nullptr) line_e = end;
+        if (line_e > line_b && match_line(line_b, line_e, filter, segment)) {
+            emit(line_b, line_e, segment, count_only, out);
+        }
+        p = line_e + 1;
+    }
+}
+
+// ---------------------------------------------------------------- 任务切分
+
+struct Task {
+    const Segment* segment;
+    size_t begin;
+    size_t end;
+    bool block;   // 压缩段中的一个块帧，begin 为帧偏移
+};
+
+bool bound_epoch_ns(const TimeBound& bound, const Segment& segment, int64_t& ns) {
+    if (!bound.set || !(bound.has_date || segment.has_date)) return false;
+    ns = local_epoch_ns(bound.has_date ? bound.day : segment.day, bound.ms);
+    return true;
+}
+
+void plan_segment(const Segment& segment, const Filter& filter, unsigned threads, std::vector<Task>& tasks) {
+    const char* data = segment.file->data();
+    const size_t size = segment.file->size();
+    int64_t from_ns = 0, to_ns = 0;
+    const bool has_from = bound_epoch_ns(filter.from, segment, from_ns);
+    const bool has_to = bound_epoch_ns(filter.to, segment, to_ns);
+    const int64_t slack_ns = REORDER_SLACK_MS * 1000000;
+
+    const tools::SegmentRange range = tools::segment_range(segment.path, data, size);
+    if (tools::is_compressed_segment(segment.path)) {
+        bool damaged = false;
+        const auto blocks = tools::scan_blocks(data, range.begin, range.end, damaged);
+        if (damaged) std::cerr << segment.path << ": stopped at a damaged frame" << std::endl;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (has_to && blocks[i].header.first_timestamp_ns > to_ns + slack_ns) break;
+            if (has_from && i + 1 < blocks.size() && blocks[i + 1].header.first_timestamp_ns < from_ns - slack_ns) continue;
+            tasks.push_back({&segment, blocks[i].offset, 0, true});
+        }
+        return;
+    }
+
+    size_t begin = range.begin;
+    size_t end = range.end;
+    if (has_from || has_to) {
+        logF::SegmentIndex index;
+        if (index.load(segment.path, end) && index.size() > 0) {
+            if (has_from) begin = index.begin_offset(index.seek(from_ns - slack_ns));
+            if (has_to) {
+                for (size_t i = index.seek(has_from ? from_ns - slack_ns : 0); i < index.size(); ++i) {
+                    if (index.entries()[i].first_timestamp_ns > to_ns + slack_ns) {
+                        end = index.begin_offset(i);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    if (begin >= end) return;
+    const size_t chunk = std::max(MIN_CHUNK, (end - begin) / (threads * 4) + 1);
+    while (begin < end) {
+        size_t stop = std::min(end, begin + chunk);
+        if (stop < end) {
+            const void* nl = std::memchr(data + stop, '\n', end - stop);
+            stop = nl ? static_cast<const char*>(nl) - data + 1 : end;
+        }
+        tasks.push_back({&segment, begin, stop, false});
+        begin = stop;
+    }
+}
+
+void run_task(const Task& task, const Filter& filter, bool count_only, std::vector<char>& scratch, Output& out) {
+    const char* data = task.segment->file->data();
+    if (!task.block) {
+        search_text(data + task.begin, data + task.end, filter, *task.segment, count_only, out);
+        return;
+    }
+    logF::BlockHeader header;
+    std::memcpy(&header, data + task.begin, sizeof(header));
+    scratch.resize(header.uncompressed_len);
+    if (!logF::decode_block(header, data + task.begin + sizeof(header), scratch.data())) {
+        std::cerr << task.segment->path << ": corrupt block at offset " << task.begin << std::endl;
+        return;
+    }
+    search_text(scratch.data(), scratch.data() + scratch.size(), filter, *task.segment, count_only, out);
+}
+
+// 分批并行执行，按任务顺序输出
+uint64_t run_tasks(const std::vector<Task>& tasks, const Filter& filter, bool count_only, unsigned threads) {
+    uint64_t total = 0;
+    const size_t wave = threads * 4;
+    std::vector<Output> outputs(wave);
+    for (size_t start = 0; start < tasks.size(); start += wave) {
+        const size_t count = std::min(wave, tasks.size() - start);
+        std::atomic<size_t> next{0};
+        auto work = [&]() {
+            std::vector<char> scratch;
+            for (size_t i; (i = next.fetch_add(1)) < count;) {
+                outputs[i] = Output();
+                run_task(tasks[start + i], filter, count_only, scratch, outputs[i]);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t) workers.emplace_back(work);
+        work();
+        for (auto& worker : workers) worker.join();
+        for (size_t i = 0; i < count; ++i) {
+            std::fwrite(outputs[i].text.data(), 1, outputs[i].text.size(), stdout);
+            total += outputs[i].count;
+        }
+    }
+    return total;
+}
+
+// ---------------------------------------------------------------- 跟踪
+
+void init_segment(Segment& segment, const std::string& path, bool with_name) {
+    segment.path = path;
+    segment.display = with_name ? path : std::string();
+    const std::string name = path.substr(path.rfind('/') + 1);
+    segment.has_date = parse_date(name.c_str(), segment.day);
+}
+
+// 用 pread 而不是 mmap：写入端关闭段时会截断文件，映射越界访问会触发 SIGBUS
+void follow(const std::string& input, bool is_dir, const Filter& filter, bool with_name) {
+    auto newest = [&]() {
+        if (!is_dir) return input;
+        const auto segments = tools::list_segments(input);
+        return segments.empty() ? std::string() : segments.back();
+    };
+    Segment segment;
+    std::string path = newest();
+    int fd = -1;
+    size_t offset = 0;
+    std::string pending;
+    std::vector<char> buffer(1 << 20);
+    std::vector<char> decoded;
+    bool at_start = true;
+
+    while (true) {
+        if (fd == -1 && !path.empty()) {
+            fd = ::open(path.c_str(), O_RDONLY);
+            init_segment(segment, path, with_name);
+            offset = 0;
+            pending.clear();
+        }
+        bool progressed = false;
+        if (fd != -1) {
+            // 首次打开时跳到已有数据的末尾，只输出之后的新内容
+            const bool skip = at_start;
+            // 带文件头的段每轮重读 committed，只读到写入端已提交的位置
+            uint64_t limit = UINT64_MAX;
+            char head[logF::SEGMENT_HEADER_SIZE];
+            logF::SegmentInfo info;
+            if (pread(fd, head, sizeof(head), 0) == static_cast<ssize_t>(sizeof(head)) &&
+                logF::parse_segment_header(head, sizeof(head), info)) {
+                limit = info.committed;
+                offset = std::max<size_t>(offset, logF::SEGMENT_HEADER_SIZE);
+            }
+            Output out;
+            if (tools::is_compressed_segment(path)) {
+                logF::BlockHeader header;
+                while (offset + sizeof(header) <= limit &&
+                       pread(fd, &header, sizeof(header), offset) == static_cast<ssize_t>(sizeof(header)) &&
+                       header.magic == logF::BLOCK_MAGIC &&
+                       offset + sizeof(header) + header.compressed_len <= limit) {
+                    buffer.resize(std::max<size_t>(buffer.size(), header.compressed_len));
+                    if (pread(fd, buffer.data(), header.compressed_len, offset + sizeof(header)) !=
+                        static_cast<ssize_t>(header.compressed_len)) {
+                        break;
+                    }
+                    offset += sizeof(header) + header.compressed_len;
+                    progressed = true;
+                    if (skip) continue;
+                    decoded.resize(header.uncompressed_len);
+                    if (logF::decode_block(header, buffer.data(), decoded.data())) {
+                        search_text(decoded.data(), decoded.data() + decoded.size(), filter, segment, false, out);
+                    }
+                }
+            } else {
+                ssize_t n;
+                while (offset < limit &&
+                       (n = pread(fd, buffer.data(), std::min<uint64_t>(buffer.size(), limit - offset), offset)) > 0) {
+                    const size_t valid = tools::text_length(buffer.data(), static_cast<size_t>(n));
+                    offset += valid;
+                    if (valid > 0) progressed = true;
+                    pending.append(buffer.data(), valid);
+                    const size_t last_nl = pending.rfind('\n');
+                    if (last_nl != std::string::npos) {
+                        if (!skip) {
+                            search_text(pending.data(), pending.data() + last_nl, filter, segment, false, out);
+                        }
+                        pending.erase(0, last_nl + 1);
+                    }
+                    if (valid < static_cast<size_t>(n)) break;   // 到达 0 填充
+                }
+            }
+            at_start = false;
+            if (!out.text.empty()) {
+                std::fwrite(out.text.data(), 1, out.text.size(), stdout);
+                std::fflush(stdout);
+            }
+        }
+        if (progressed) continue;
+
+        // 出现新的段时，旧段已经被写入端关闭，读完剩余内容后切换
+        const std::string latest = newest();
+        if (!latest.empty() && latest != path) {
+            if (fd != -1) ::close(fd);
+            fd = -1;
+            path = latest;
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+}
+
+int usage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [-e TEXT] [-E REGEX] [--level LEVEL] [--site FILE[:LINE]] [--from TIME] [--to TIME]"
+                 " [-c] [-H|-h] [-f] [--threads N] PATH..." << std::endl;
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Filter filter;
+    bool count_only = false;
+    bool follow_mode = false;
+    int with_name = -1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "-e" && has_value) {
+            filter.literal = argv[++i];
+        } else if (arg == "-E" && has_value) {
+            try {
+                filter.regex.emplace(argv[++i], std::regex::ECMAScript | std::regex::optimize);
+            } catch (const std::regex_error& e) {
+                std::cerr << "invalid regex: " << e.what() << std::endl;
+                return 2;
+            }
+            if (filter.literal.empty()) filter.literal = required_literal(argv[i]);
+        } else if (arg == "--level" && has_value) {
+            const std::string level = argv[++i];
+            for (int l = 0; l < 5; ++l) {
+                if (level == LEVEL_NAMES[l]) filter.min_level = l;
+            }
+            if (filter.min_level < 0) return usage(argv[0]);
+        } else if (arg == "--site" && has_value) {
+            const std::string site = argv[++i];
+            const size_t colon = site.rfind(':');
+            filter.site_file = site.substr(0, colon);
+            if (colon != std::string::npos) filter.site_line = std::strtol(site.c_str() + colon + 1, nullptr, 10);
+        } else if ((arg == "--from" || arg == "--to") && has_value) {
+            if (!parse_bound(argv[++i], arg == "--from" ? filter.from : filter.to)) return usage(argv[0]);
+        } else if (arg == "-c") {
+            count_only = true;
+        } else if (arg == "-H") {
+            with_name = 1;
+        } else if (arg == "-h") {
+            with_name = 0;
+        } else if (arg == "-f") {
+            follow_mode = true;
+        } else if (arg == "--threads" && has_value) {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (!arg.empty() && arg[0] != '-') {
+            inputs.push_back(arg);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (inputs.empty()) return usage(argv[0]);
+
+    if (follow_mode) {
+        struct stat st;
+        const bool is_dir = stat(inputs.back().c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        follow(inputs.back(), is_dir, filter, with_name == 1);
+        return 0;
+    }
+
+    std::vector<std::string> paths;
+    for (const auto& input : inputs) {
+        struct stat st;
+        if (stat(input.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            const auto segments = tools::list_segments(input);
+            paths.insert(paths.end(), segments.begin(), segments.end());
+        } else {
+            paths.push_back(input);
+        }
+    }
+    const bool show_name = with_name == 1 || (with_name == -1 && paths.size() > 1);
+
+    std::vector<Segment> segments(paths.size());
+    std::vector<Task> tasks;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        init_segment(segments[i], paths[i], show_name);
+        segments[i].file = std::make_unique<tools::MappedFile>(paths[i]);
+        if (!segments[i].file->ok()) {
+            std::cerr << "cannot open " << paths[i] << std::endl;
+            continue;
+        }
+        plan_segment(segments[i], filter, threads, tasks);
+    }
+    const uint64_t matches = run_tasks(tasks, filter, count_only, threads);
+    if (count_only) {
+        std::printf("%llu\n", static_cast<unsigned long long>(matches));
+    }
+    std::fflush(stdout);
+    return matches > 0 ? 0 : 1;
+}
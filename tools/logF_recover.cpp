@@ -0,0 +1,42 @@
+// 段恢复工具：把崩溃后留下的 state=O 的段截断到最后一条完整的记录并标记为已关闭。
+//   logF_recover DIR...                 写入进程已不存在的段
+//   logF_recover --force DIR...         不检查写入进程（从其他主机拷来的目录）
+//   logF_recover --dry-run DIR...       只报告，不修改文件
+//   logF_recover --threads N DIR...     并行处理（默认使用全部核心）
+// Consumer 和 FileSink 启动时会自动恢复自己的目录，这个工具用于离线处理。
+
+#include "../include/segment_header.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    unsigned threads = 0;
+    bool force = false;
+    bool dry_run = false;
+    std::vector<std::string> dirs;
+    bool bad_option = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (arg == "--force") force = true;
+        else if (arg == "--dry-run") dry_run = true;
+        else if (!arg.empty() && arg[0] == '-') bad_option = true;
+        else dirs.push_back(arg);
+    }
+    if (dirs.empty() || bad_option) {
+        std::cerr << "Usage: " << argv[0] << " [--threads N] [--dry-run] [--force] DIR..." << std::endl;
+        return 1;
+    }
+    logF::RecoveryStats total;
+    for (const auto& dir : dirs) {
+        const logF::RecoveryStats stats = logF::recover_segments(dir, threads, force, dry_run);
+        total.scanned += stats.scanned;
+        total.recovered += stats.recovered;
+        total.skipped_live += stats.skipped_live;
+        total.trimmed_bytes += stats.trimmed_bytes;
+    }
+    std::cerr << "scanned " << total.scanned << ", " << (dry_run ? "would recover " : "recovered ") << total.recovered
+              << ", skipped live " << total.skipped_live << ", trimmed bytes " << total.trimmed_bytes << std::endl;
+    return 0;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+// 工具共用：只读映射段文件、扫描压缩段的块帧、按文件名排序段。
+
+#include "../include/lz_block.h"
+#include "../include/segment_header.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace tools {
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ == -1) return;
+        struct stat st;
+        if (fstat(fd_, &st) == 0 && st.st_size > 0) {
+            size_ = static_cast<size_t>(st.st_size);
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            data_ = p == MAP_FAILED ? nullptr : static_cast<const char*>(p);
+            if (data_) madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+        }
+    }
+    ~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+        if (fd_ != -1) ::close(fd_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const { return fd_ != -1; }
+    const char* data() const { return data_; }
+    size_t size() const { return data_ ? size_ : 0; }
+
+private:
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+struct Block {
+    size_t offset;
+    logF::BlockHeader header;
+};
+
+// 扫描 [begin, size) 中的帧头，遇到 0 填充的尾部或损坏的帧时停止；damaged 表示停在了非 0 的无效数据上
+inline std::vector<Block> scan_blocks(const char* data, size_t begin, size_t size, bool& damaged) {
+    std::vector<Block> blocks;
+    size_t offset = begin;
+    damaged = false;
+    while (offset + sizeof(logF::BlockHeader) <= size) {
+        logF::BlockHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        if (header.magic != logF::BLOCK_MAGIC) {
+            damaged = header.magic != 0;
+            break;
+        }
+        if (header.compressed_len > size - offset - sizeof(header)) {
+            damaged = true;
+            break;
+        }
+        blocks.push_back({offset, header});
+        offset += sizeof(header) + header.compressed_len;
+    }
+    return blocks;
+}
+
+// 未关闭的文本段尾部是 ftruncate 留下的 0；文本中不含 0，按"是否为 0"二分找到数据末尾
+inline size_t text_length(const char* data, size_t size) {
+    size_t lo = 0, hi = size;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (data[mid] == '\0') {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+inline bool is_compressed_segment(const std::string& path) {
+    return path.size() >= 5 && path.compare(path.size() - 5, 5, ".logz") == 0;
+}
+
+// 段的数据区间：带文件头的段为 [文件头之后, committed)，写入中的段也不必扫描尾部；
+// 没有文件头的旧格式段从 0 开始，文本段按 0 填充找结尾，压缩段由 scan_blocks 判断
+struct SegmentRange {
+    size_t begin;
+    size_t end;
+};
+
+inline SegmentRange segment_range(const std::string& path, const char* data, size_t size) {
+    logF::SegmentInfo info;
+    if (logF::parse_segment_header(data, size, info)) {
+        return {logF::SEGMENT_HEADER_SIZE, static_cast<size_t>(std::min<uint64_t>(info.committed, size))};
+    }
+    return {0, is_compressed_segment(path) ? size : text_length(data, size)};
+}
+
+// 段按 (周期, index) 排序：YYYY-MM-DD[_HH]_<index>.log*
+inline bool segment_less(const std::string& a, const std::string& b) {
+    auto split = [](const std::string& path) {
+        const std::string name = path.substr(path.rfind('/') + 1);
+        const size_t dot = name.find('.');
+        const size_t underscore = name.rfind('_', dot);
+        if (underscore == std::string::npos) return std::make_pair(name, -1L);
+        return std::make_pair(name.substr(0, underscore), std::strtol(name.c_str() + underscore + 1, nullptr, 10));
+    };
+    return split(a) < split(b);
+}
+
+// 目录展开为其中的段（不含 .idx），按时间顺序排列
+inline std::vector<std::string> list_segments(const std::string& dir_path) {
+    std::vector<std::string> segments;
+    DIR* dir = opendir(dir_path.c_str());
+    if (dir == nullptr) return segments;
+    while (dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        const bool is_segment = name.find(".log") != std::string::npos &&
+                                (name.size() < 4 || name.compare(name.size() - 4, 4, ".idx") != 0);
+        if (is_segment) segments.push_back(dir_path + "/" + name);
+    }
+    closedir(dir);
+    std::sort(segments.begin(), segments.end(), segment_less);
+    return segments;
+}
+
+}